@@ -0,0 +1,22 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <Arduino.h>
+
+// ---------- Retry backoff ----------
+// Doubles the wait after every failure up to maxMs; one success resets it.
+struct Backoff {
+  unsigned long minMs, maxMs;
+  unsigned long delayMs = 0, retryAt = 0;
+
+  Backoff(unsigned long lo, unsigned long hi) : minMs(lo), maxMs(hi) {}
+
+  bool ready() const { return !delayMs || (long)(millis() - retryAt) >= 0; }
+  void fail() {
+    delayMs = delayMs ? min(delayMs * 2, maxMs) : minMs;
+    retryAt = millis() + delayMs;
+  }
+  void ok() { delayMs = 0; }
+};
+
+#endif
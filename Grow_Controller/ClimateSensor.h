@@ -0,0 +1,186 @@
+#ifndef CLIMATESENSOR_H
+#define CLIMATESENSOR_H
+
+#include <Wire.h>
+
+// === AHT20 timing ===
+#define AHT20_ADDR          0x38
+#define TCA9548A_ADDR       0x70
+#define AHT_SAMPLE_MS       2000    // one measurement per sensor per period
+#define AHT_CONVERT_MS        80    // datasheet conversion time
+#define AHT_RETRY_MS          10    // re-check when the sensor is still busy
+#define AHT_MAX_RETRIES        5
+#define AHT_STALE_MS        (3 * AHT_SAMPLE_MS)   // older readings are ignored
+#define AHT_INIT_MS           10    // calibration command settle time
+#define AHT_PROBE_MS        5000    // retry period while a sensor is missing
+#define AHT_LOST_AFTER         3    // failed readings in a row before re-probing
+
+// ---------- Non-blocking AHT20 driver ----------
+// poll() advances a small state machine: trigger a conversion and return,
+// then collect the result on a later call once AHT_CONVERT_MS has passed.
+// A sensor lives either directly on a bus (Wire, Wire1) or behind a
+// TCA9548A multiplexer channel. Detection is part of the same state
+// machine, so a sensor missing at boot, or unplugged later, is simply
+// probed again every AHT_PROBE_MS until it answers.
+class Aht20 {
+public:
+  float temperature = NAN, humidity = NAN;
+  unsigned long stamp = 0;       // millis() of the last good reading
+  unsigned long errors = 0;
+
+  Aht20(TwoWire &bus, int8_t muxChannel = -1, uint8_t muxAddr = TCA9548A_ADDR)
+    : bus(bus), muxChannel(muxChannel), muxAddr(muxAddr) {}
+
+  // Start detection on the next poll(); never touches the bus itself.
+  void begin() {
+    present = false;
+    state = AHT_PROBE;
+    nextAt = millis();
+  }
+
+  void poll() {
+    unsigned long now = millis();
+    if ((long)(now - nextAt) < 0) return;
+
+    if (state == AHT_PROBE) {
+      probe(now);
+      return;
+    }
+
+    if (state == AHT_IDLE) {
+      const uint8_t trigger[] = { 0xAC, 0x33, 0x00 };
+      if (select() && writeBytes(trigger, sizeof(trigger))) {
+        state = AHT_MEASURING;
+        retries = 0;
+        nextAt = now + AHT_CONVERT_MS;
+      } else {
+        fail(now);
+      }
+      return;
+    }
+
+    // AHT_MEASURING: conversion should be done
+    uint8_t d[7];
+    if (!select() || !readBytes(d, sizeof(d))) { fail(now); return; }
+    if (d[0] & 0x80) {                         // still busy
+      if (++retries > AHT_MAX_RETRIES) fail(now);
+      else nextAt = now + AHT_RETRY_MS;
+      return;
+    }
+    if (crc8(d, 6) != d[6]) { fail(now); return; }
+
+    uint32_t rawH = ((uint32_t)d[1] << 12) | ((uint32_t)d[2] << 4) | (d[3] >> 4);
+    uint32_t rawT = ((uint32_t)(d[3] & 0x0F) << 16) | ((uint32_t)d[4] << 8) | d[5];
+    humidity    = rawH * (100.0f / 1048576.0f);
+    temperature = rawT * (200.0f / 1048576.0f) - 50.0f;
+    stamp = now;
+    failStreak = 0;
+    state = AHT_IDLE;
+    nextAt = now - AHT_CONVERT_MS + AHT_SAMPLE_MS;   // keep the trigger cadence
+  }
+
+  bool isPresent() const { return present; }
+  bool valid() const { return present && stamp && millis() - stamp < AHT_STALE_MS; }
+
+private:
+  enum State : uint8_t { AHT_PROBE, AHT_IDLE, AHT_MEASURING };
+
+  TwoWire &bus;
+  int8_t   muxChannel;
+  uint8_t  muxAddr;
+  bool     present = false;
+  State    state = AHT_IDLE;
+  uint8_t  retries = 0, failStreak = 0;
+  unsigned long nextAt = 0;
+
+  // Status read answers if the sensor is there; calibrate it if needed.
+  void probe(unsigned long now) {
+    uint8_t status;
+    if (!select() || !readBytes(&status, 1)) { nextAt = now + AHT_PROBE_MS; return; }
+    nextAt = now;
+    if (!(status & 0x08)) {                    // not calibrated: send init
+      const uint8_t init[] = { 0xBE, 0x08, 0x00 };
+      if (!writeBytes(init, sizeof(init))) { nextAt = now + AHT_PROBE_MS; return; }
+      nextAt = now + AHT_INIT_MS;
+    }
+    present = true;
+    failStreak = 0;
+    state = AHT_IDLE;
+  }
+
+  void fail(unsigned long now) {
+    errors++;
+    if (++failStreak >= AHT_LOST_AFTER) {      // gone: back to probing
+      present = false;
+      state = AHT_PROBE;
+      nextAt = now + AHT_PROBE_MS;
+      return;
+    }
+    state = AHT_IDLE;
+    nextAt = now + AHT_SAMPLE_MS;
+  }
+
+  bool select() {
+    if (muxChannel < 0) return true;
+    bus.beginTransmission(muxAddr);
+    bus.write((uint8_t)(1 << muxChannel));
+    return bus.endTransmission() == 0;
+  }
+
+  bool writeBytes(const uint8_t *d, size_t n) {
+    bus.beginTransmission(AHT20_ADDR);
+    bus.write(d, n);
+    return bus.endTransmission() == 0;
+  }
+
+  bool readBytes(uint8_t *d, size_t n) {
+    if (bus.requestFrom((uint8_t)AHT20_ADDR, (uint8_t)n) != n) return false;
+    for (size_t i = 0; i < n; i++) d[i] = bus.read();
+    return true;
+  }
+
+  static uint8_t crc8(const uint8_t *d, size_t n) {
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < n; i++) {
+      crc ^= d[i];
+      for (int b = 0; b < 8; b++) crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+    return crc;
+  }
+};
+
+// ---------- Per-room sensor binding ----------
+// Averages the fresh readings of every sensor bound to a room.
+class ClimateGroup {
+public:
+  static const int MAX_SENSORS = 3;
+
+  void bind(Aht20 *s) { if (count < MAX_SENSORS) sensors[count++] = s; }
+  void clear() { count = 0; }
+
+  bool read(float &temp, float &hum) const {
+    float t = 0, h = 0;
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+      if (!sensors[i]->valid()) continue;
+      t += sensors[i]->temperature;
+      h += sensors[i]->humidity;
+      n++;
+    }
+    if (!n) return false;
+    temp = t / n;
+    hum  = h / n;
+    return true;
+  }
+
+  bool hasPresent() const {
+    for (int i = 0; i < count; i++) if (sensors[i]->isPresent()) return true;
+    return false;
+  }
+
+private:
+  Aht20 *sensors[MAX_SENSORS];
+  int    count = 0;
+};
+
+#endif
@@ -1,24 +1,52 @@
-#ifndef CONFIG_H
-#define CONFIG_H
-
-#include <Wire.h>
-#include <Adafruit_AHTX0.h>
-#include <Preferences.h>
-
-extern Adafruit_AHTX0 aht;
-extern Preferences prefs;
-
-// Shared constants ----------------------------------------------------
-#define DEFAULT_SOIL_THRESHOLD     200
-#define DEFAULT_TEMP_THRESHOLD     1.0
-#define DEFAULT_HUMIDITY_THRESHOLD 5.0
-#define DEFAULT_MIN_RUN_TIME_MS    10000UL   // 10 s minimum relay run
-
-// Shared post-water delay (minutes)
-#define POST_WATER_DELAY_MIN       60
-
-// Function declarations
-void loadConfig(struct RoomConfig &cfg, const char* ns);
-void saveConfig(const struct RoomConfig &cfg, const char* ns);
-
-#endif
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <Wire.h>
+#include <Preferences.h>
+
+extern Preferences prefs;
+
+// Shared constants ----------------------------------------------------
+#define DEFAULT_SOIL_THRESHOLD     8.0       // % below target before a zone floods
+#define DEFAULT_TEMP_THRESHOLD     1.0
+#define DEFAULT_HUMIDITY_THRESHOLD 5.0
+#define DEFAULT_MIN_RUN_TIME_MS    10000UL   // 10 s minimum relay run
+
+// PID climate (`set <room> pid 1`); gains in %/°C, %/(°C·min), %·min/°C
+#define DEFAULT_PID_KP             50.0
+#define DEFAULT_PID_KI             0.8
+#define DEFAULT_PID_KD             0.0
+
+// Humidity control (`set <room> humctl 0|1|2`: off, RH, VPD)
+#define DEFAULT_VPD_THRESHOLD      0.15      // kPa either side of the target
+#define VPD_LEAF_OFFSET            -1.5      // leaf below air temperature under the lights (°C)
+
+// Lights-on time of day once the wall clock is set (hour, local time)
+#define DEFAULT_LIGHT_START_HOUR   6
+
+// Re-plan light events if the wall clock steps by more than this (ms)
+#define LIGHT_CLOCK_SLEW_MS        2000
+
+// Shared post-water delay (minutes)
+#define POST_WATER_DELAY_MIN       60
+
+// Room table limits (see Rooms.h)
+#define MAX_ROOMS                  6
+#define ROOM_MAX_PROBES            8
+#define ROOM_MAX_ZONES             4
+
+// Shared flood supply (see Irrigation.h)
+#define IRR_MAX_ACTIVE             2         // zones flooding at once
+#define IRR_SUPPLY_MA              2500      // pump and solenoid current the supply carries
+#define IRR_DEADLINE_MIN           30        // a dry zone queued this long goes first
+
+// Software flood stop if the hardware timer never fires (ms past duration)
+#define FLOOD_BACKSTOP_MS          2000UL
+
+// Alert when temperature leaves the hysteresis band by more than this (°C)
+#define ALERT_TEMP_MARGIN          2.0
+
+// Quiet time after the last edit before settings are written to NVS
+#define CONFIG_SAVE_DELAY_MS       10000UL
+
+#endif
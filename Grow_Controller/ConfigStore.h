@@ -0,0 +1,267 @@
+#ifndef CONFIGSTORE_H
+#define CONFIGSTORE_H
+
+#include "Config.h"
+#include "RoomBase.h"
+#include "Log.h"
+
+// ---------- Persistent config store ----------
+// Every room's settings live in one CRC-protected NVS blob, read in a
+// single access at boot. Edits only mark the store dirty; the blob is
+// rewritten once CONFIG_SAVE_DELAY_MS passes without another edit, and
+// never when the contents match what is already in flash.
+//
+// Layout: ConfigHeader followed by roomCount records of roomSize bytes.
+// New fields go at the end of StoredRoom; an older, shorter record then
+// loads with the new fields left at their defaults. Bump CONFIG_VERSION
+// and convert in migrate() when an existing field changes meaning.
+
+#define CONFIG_NS         "config"
+#define CONFIG_KEY        "blob"
+#define CONFIG_VERSION    2   // 2: soil target and threshold in % instead of counts
+#define CONFIG_MAX_ROOMS  MAX_ROOMS
+#define CONFIG_BLOB_MAX   512   // room for records grown by newer firmware
+
+// On-flash form of RoomConfig (fixed width, no padding)
+struct StoredRoom {
+  float    idealTemp;
+  float    idealHumidity;
+  float    idealSoil;       // int32 counts before version 2
+  float    tempThreshold;
+  float    humidityThreshold;
+  float    soilThreshold;   // likewise
+  uint32_t lightOnMs;
+  uint32_t lightOffMs;
+  uint32_t lightStartMs;   // added after v1 shipped; older records keep the default
+  int32_t  climateMode;    // fields from here on likewise
+  float    pidKp;
+  float    pidKi;
+  float    pidKd;
+  int32_t  humidityMode;
+  float    vpdTarget;
+  float    vpdThreshold;
+};
+
+struct ConfigHeader {
+  uint16_t version;
+  uint8_t  roomCount;
+  uint8_t  roomSize;
+  uint32_t crc;        // CRC-32 of the room records
+};
+
+static_assert(sizeof(ConfigHeader) + CONFIG_MAX_ROOMS * sizeof(StoredRoom) <= CONFIG_BLOB_MAX,
+              "raise CONFIG_BLOB_MAX");
+
+inline uint32_t crc32(const uint8_t *p, size_t n, uint32_t crc = 0) {
+  crc = ~crc;
+  while (n--) {
+    crc ^= *p++;
+    for (int i = 0; i < 8; i++) crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+class ConfigStore {
+public:
+  enum SaveResult { SAVE_UNCHANGED, SAVE_WRITTEN, SAVE_FAILED };
+
+  uint32_t writes = 0;   // blob commits since boot
+
+  // Register a room in blob order. legacyNs is the namespace the old
+  // per-key format used, imported once if no blob exists yet.
+  void add(RoomConfig *cfg, const char *legacyNs) {
+    if (count < CONFIG_MAX_ROOMS) { rooms[count] = cfg; legacy[count] = legacyNs; count++; }
+  }
+
+  // Load every room in one NVS read. Rooms keep their defaults when
+  // nothing valid is stored.
+  void load() {
+    uint8_t buf[CONFIG_BLOB_MAX];
+    logger.add(logSrc);
+    prefs.begin(CONFIG_NS, true);
+    size_t len = prefs.getBytes(CONFIG_KEY, buf, sizeof(buf));
+    prefs.end();
+
+    if (len == 0) {
+      importLegacy();
+    } else if (!decode(buf, len)) {
+      logger.warn(logSrc, "⚠️ Stored config corrupt, using defaults");
+    } else {
+      logger.info(logSrc, "✅ Config v%u loaded", ((ConfigHeader *)buf)->version);
+    }
+    snapshot(saved);   // flash now matches memory unless import changed it
+    if (imported && flush() == SAVE_WRITTEN) clearLegacy();
+  }
+
+  // A field was edited; the save happens after a quiet period.
+  void touch() {
+    dirty = true;
+    dueAt = millis() + CONFIG_SAVE_DELAY_MS;
+  }
+
+  bool pending() const { return dirty; }
+
+  // Call periodically; commits a coalesced save once it is due.
+  void poll() {
+    if (dirty && (long)(millis() - dueAt) >= 0) flush();
+  }
+
+  // Write now if anything differs from flash.
+  SaveResult flush() {
+    dirty = false;
+    StoredRoom now[CONFIG_MAX_ROOMS];
+    snapshot(now);
+    if (!imported && memcmp(now, saved, count * sizeof(StoredRoom)) == 0) return SAVE_UNCHANGED;
+
+    uint8_t buf[sizeof(ConfigHeader) + sizeof(now)];
+    ConfigHeader hdr = { CONFIG_VERSION, count, sizeof(StoredRoom),
+                         crc32((const uint8_t *)now, count * sizeof(StoredRoom)) };
+    memcpy(buf, &hdr, sizeof(hdr));
+    memcpy(buf + sizeof(hdr), now, count * sizeof(StoredRoom));
+    size_t len = sizeof(hdr) + count * sizeof(StoredRoom);
+
+    prefs.begin(CONFIG_NS, false);
+    bool ok = prefs.putBytes(CONFIG_KEY, buf, len) == len;
+    prefs.end();
+    if (!ok) {
+      logger.error(logSrc, "❌ Config write failed, retrying later");
+      touch();
+      return SAVE_FAILED;
+    }
+    memcpy(saved, now, sizeof(now));
+    imported = false;
+    writes++;
+    return SAVE_WRITTEN;
+  }
+
+private:
+  RoomConfig *rooms[CONFIG_MAX_ROOMS];
+  const char *legacy[CONFIG_MAX_ROOMS];
+  uint8_t     count = 0;
+  StoredRoom  saved[CONFIG_MAX_ROOMS];   // what flash holds
+  bool        dirty = false;
+  bool        imported = false;
+  unsigned long dueAt = 0;
+  LogSource   logSrc{"config"};
+
+  static StoredRoom pack(const RoomConfig &c) {
+    StoredRoom s;
+    memset(&s, 0, sizeof(s));
+    s.idealTemp         = c.idealTemp;
+    s.idealHumidity     = c.idealHumidity;
+    s.idealSoil         = c.idealSoil;
+    s.tempThreshold     = c.tempThreshold;
+    s.humidityThreshold = c.humidityThreshold;
+    s.soilThreshold     = c.soilThreshold;
+    s.lightOnMs         = c.lightOnDuration;
+    s.lightOffMs        = c.lightOffDuration;
+    s.lightStartMs      = c.lightStart;
+    s.climateMode       = c.climateMode;
+    s.pidKp             = c.pidKp;
+    s.pidKi             = c.pidKi;
+    s.pidKd             = c.pidKd;
+    s.humidityMode      = c.humidityMode;
+    s.vpdTarget         = c.vpdTarget;
+    s.vpdThreshold      = c.vpdThreshold;
+    return s;
+  }
+
+  static void unpack(const StoredRoom &s, RoomConfig &c) {
+    c.idealTemp         = s.idealTemp;
+    c.idealHumidity     = s.idealHumidity;
+    c.idealSoil         = s.idealSoil;
+    c.tempThreshold     = s.tempThreshold;
+    c.humidityThreshold = s.humidityThreshold;
+    c.soilThreshold     = s.soilThreshold;
+    c.lightOnDuration   = s.lightOnMs;
+    c.lightOffDuration  = s.lightOffMs;
+    c.lightStart        = s.lightStartMs;
+    c.climateMode       = s.climateMode;
+    c.pidKp             = s.pidKp;
+    c.pidKi             = s.pidKi;
+    c.pidKd             = s.pidKd;
+    c.humidityMode      = s.humidityMode;
+    c.vpdTarget         = s.vpdTarget;
+    c.vpdThreshold      = s.vpdThreshold;
+  }
+
+  void snapshot(StoredRoom *out) const {
+    memset(out, 0, CONFIG_MAX_ROOMS * sizeof(StoredRoom));
+    for (uint8_t i = 0; i < count; i++) out[i] = pack(*rooms[i]);
+  }
+
+  bool decode(const uint8_t *buf, size_t len) {
+    ConfigHeader hdr;
+    if (len < sizeof(hdr)) return false;
+    memcpy(&hdr, buf, sizeof(hdr));
+    const uint8_t *body = buf + sizeof(hdr);
+    size_t bodyLen = (size_t)hdr.roomCount * hdr.roomSize;
+    if (hdr.roomSize == 0 || sizeof(hdr) + bodyLen != len) return false;
+    if (crc32(body, bodyLen) != hdr.crc) return false;
+
+    // Start each record from the current values so fields the blob
+    // predates keep their defaults, then take what the blob has.
+    size_t take = min((size_t)hdr.roomSize, sizeof(StoredRoom));
+    for (uint8_t i = 0; i < count && i < hdr.roomCount; i++) {
+      StoredRoom s = pack(*rooms[i]), defaults = s;
+      memcpy(&s, body + i * hdr.roomSize, take);
+      migrate(s, hdr.version);
+      // a soil target typed in counts after the switch to % would flood nonstop
+      if (!(s.idealSoil >= 0 && s.idealSoil <= 100)) s.idealSoil = defaults.idealSoil;
+      if (!(s.soilThreshold >= 0 && s.soilThreshold <= 100)) s.soilThreshold = defaults.soilThreshold;
+      unpack(s, *rooms[i]);
+    }
+    if (hdr.version != CONFIG_VERSION) imported = true;   // rewrite in current form
+    return true;
+  }
+
+  // Convert a record written by an older CONFIG_VERSION
+  static void migrate(StoredRoom &s, uint16_t version) {
+    if (version < 2) {   // soil fields held raw counts
+      int32_t target, threshold;
+      memcpy(&target, &s.idealSoil, sizeof(target));
+      memcpy(&threshold, &s.soilThreshold, sizeof(threshold));
+      s.idealSoil = countsToPct(target - SOIL_DRY_RAW);
+      s.soilThreshold = countsToPct(threshold);
+    }
+  }
+
+  // Old raw soil settings through the default probe curve, the best guess
+  // without the probe's calibration
+  static float countsToPct(int32_t counts) {
+    return roundf(counts * 1000.0f / (SOIL_WET_RAW - SOIL_DRY_RAW)) / 10;
+  }
+
+  // Version 0: one namespace per room, one key per field, no light times.
+  void importLegacy() {
+    for (uint8_t i = 0; i < count; i++) {
+      if (!legacy[i] || !prefs.begin(legacy[i], true)) continue;
+      RoomConfig &cfg = *rooms[i];
+      if (prefs.isKey("temp")) {
+        cfg.idealTemp         = prefs.getFloat("temp", cfg.idealTemp);
+        cfg.idealHumidity     = prefs.getFloat("hum",  cfg.idealHumidity);
+        cfg.tempThreshold     = prefs.getFloat("tTh",  cfg.tempThreshold);
+        cfg.humidityThreshold = prefs.getFloat("hTh",  cfg.humidityThreshold);
+        // soil settings were raw counts
+        if (prefs.isKey("soil")) cfg.idealSoil = countsToPct(prefs.getInt("soil") - SOIL_DRY_RAW);
+        if (prefs.isKey("sTh"))  cfg.soilThreshold = countsToPct(prefs.getInt("sTh"));
+        imported = true;
+      }
+      prefs.end();
+    }
+    if (imported) logger.info(logSrc, "✅ Imported legacy config into the config blob");
+  }
+
+  // Drop the per-key namespaces once the blob holds their values.
+  void clearLegacy() {
+    for (uint8_t i = 0; i < count; i++) {
+      if (!legacy[i] || !prefs.begin(legacy[i], false)) continue;
+      prefs.clear();
+      prefs.end();
+    }
+  }
+};
+
+extern ConfigStore configStore;
+
+#endif
@@ -1,96 +1,597 @@
-#ifndef CONSOLE_H
-#define CONSOLE_H
-
-#include "VegRoom.h"
-#include "FlowerRoom.h"
-#include "OTAUpdate.h"
-#include <Preferences.h>
-
-extern VegRoom vegRoom;
-extern FlowerRoom flowerRoom;
-extern Preferences prefs;
-
-void showHelp() {
-  Serial.println("========== GREENHOUSE CONSOLE ==========");
-  Serial.println("help                       - Show this menu");
-  Serial.println("status                     - Print sensor + relay data");
-  Serial.println("set <room> <param> <value> - Change config value");
-  Serial.println("   room: veg | flower | mother");
-  Serial.println("   param: temp | humidity | soil");
-  Serial.println("save                       - Save current configs");
-  Serial.println("update                     - Perform OTA update from GitHub");
-  Serial.println("reboot                     - Restart ESP32");
-  Serial.println("----------------------------------------");
-}
-
-void showStatus(float temp, float hum, float motherSoil) {
-  Serial.printf("Temp: %.1f°C  Humidity: %.1f%%  MotherSoil: %.0f\n",
-                temp, hum, motherSoil);
-  Serial.printf("Veg -> Temp %.1f Hum %.1f Soil %d\n",
-                vegRoom.cfg.idealTemp, vegRoom.cfg.idealHumidity, vegRoom.cfg.idealSoil);
-  Serial.printf("Flower -> Temp %.1f Hum %.1f Soil %d\n",
-                flowerRoom.cfg.idealTemp, flowerRoom.cfg.idealHumidity, flowerRoom.cfg.idealSoil);
-}
-
-void saveAllConfigs() {
-  saveConfig(vegRoom.cfg, "veg");
-  saveConfig(flowerRoom.cfg, "flower");
-  Serial.println("✅ Configs saved to NVS.");
-}
-
-void handleSerial(float temp, float hum, float motherSoil) {
-  if (!Serial.available()) return;
-  String line = Serial.readStringUntil('\n');
-  line.trim();
-  if (line.length() == 0) return;
-
-  // --- core commands ---
-  if (line.equalsIgnoreCase("help")) { showHelp(); return; }
-  if (line.equalsIgnoreCase("status")) { showStatus(temp, hum, motherSoil); return; }
-  if (line.equalsIgnoreCase("save")) { saveAllConfigs(); return; }
-
-  if (line.equalsIgnoreCase("update")) {
-    Serial.println("Fetching latest firmware from GitHub...");
-    performOTA();
-    return;
-  }
-
-  if (line.equalsIgnoreCase("reboot")) {
-    Serial.println("Rebooting...");
-    delay(1000);
-    ESP.restart();
-  }
-
-  // --- handle 'set' command ---
-  if (line.startsWith("set ")) {
-    line.remove(0, 4);
-    int space1 = line.indexOf(' ');
-    if (space1 == -1) { Serial.println("Format: set <room> <param> <value>"); return; }
-
-    String room = line.substring(0, space1);
-    line.remove(0, space1 + 1);
-
-    int space2 = line.indexOf(' ');
-    if (space2 == -1) { Serial.println("Missing parameter/value"); return; }
-
-    String param = line.substring(0, space2);
-    float value = line.substring(space2 + 1).toFloat();
-
-    RoomConfig *cfg = nullptr;
-    if (room.equalsIgnoreCase("veg") || room.equalsIgnoreCase("mother")) cfg = &vegRoom.cfg;
-    else if (room.equalsIgnoreCase("flower")) cfg = &flowerRoom.cfg;
-    else { Serial.println("Room must be veg, flower or mother"); return; }
-
-    if (param.equalsIgnoreCase("temp")) cfg->idealTemp = value;
-    else if (param.equalsIgnoreCase("humidity")) cfg->idealHumidity = value;
-    else if (param.equalsIgnoreCase("soil")) cfg->idealSoil = (int)value;
-    else { Serial.println("Param must be temp, humidity, or soil"); return; }
-
-    Serial.printf("✅ Set %s %s = %.2f\n", room.c_str(), param.c_str(), value);
-    return;
-  }
-
-  Serial.println("Unknown command. Type 'help' for list.");
-}
-
-#endif
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include "Rooms.h"
+#include "Link.h"
+#include "ConfigStore.h"
+#include "History.h"
+#include "Perf.h"
+#include "Log.h"
+#include "ResumeState.h"
+#include "TimerWheel.h"
+#include "Irrigation.h"
+#include "Power.h"
+#include "SoilCalibration.h"
+#include <Preferences.h>
+#include <stdarg.h>
+
+extern Preferences prefs;
+
+// ---------- Command engine ----------
+// One dispatcher for every transport. Serial feeds it bytes, the network
+// task feeds it whole lines through commandQueue. Lines are tokenised in
+// place in a fixed buffer and looked up in constant tables, so parsing
+// never touches the heap. New settings only need a row in CONFIG_PARAMS.
+
+#define CMD_LINE_MAX    64
+#define CMD_MAX_ARGS     4
+#define CMD_PRINT_MAX  128
+
+// printf into any transport through a stack buffer (Print::printf may allocate)
+inline void cmdPrintf(Print &out, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+inline void cmdPrintf(Print &out, const char *fmt, ...) {
+  char buf[CMD_PRINT_MAX];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n > 0) out.write((const uint8_t *)buf, n < (int)sizeof(buf) ? n : sizeof(buf) - 1);
+}
+
+// Collects bytes until end of line.
+struct LineBuffer {
+  char   text[CMD_LINE_MAX];
+  size_t len = 0;
+  bool   overflow = false;
+
+  // true when a full line is ready in text
+  bool feed(char c) {
+    if (c == '\r' || c == '\n') {
+      if (len == 0 && !overflow) return false;
+      text[len] = '\0';
+      len = 0;
+      if (overflow) { overflow = false; text[0] = '\0'; }
+      return true;
+    }
+    if (len < CMD_LINE_MAX - 1) text[len++] = c;
+    else overflow = true;
+    return false;
+  }
+};
+
+// ---------- Settable parameters ----------
+// Exactly one member pointer is set per row; light durations are in hours.
+// pid is the ClimateMode: 0 hysteresis, 1 PID with the kp/ki/kd gains.
+// humctl is the HumidityMode: 0 off, 1 humidity ± humth, 2 vpd ± vpdth.
+// `set` rejects values outside [lo, hi]; int rows take whole numbers only.
+struct ConfigParam {
+  const char *name;
+  const char *unit;
+  float RoomConfig::*f;
+  int RoomConfig::*i;
+  unsigned long RoomConfig::*hours;
+  float lo, hi;
+};
+
+constexpr ConfigParam CONFIG_PARAMS[] = {
+  { "temp",       "°C",       &RoomConfig::idealTemp,         nullptr,                    nullptr,                          5,   40 },
+  { "humidity",   "%",        &RoomConfig::idealHumidity,     nullptr,                    nullptr,                          0,  100 },
+  { "soil",       "%",        &RoomConfig::idealSoil,         nullptr,                    nullptr,                          0,  100 },
+  { "tempth",     "°C",       &RoomConfig::tempThreshold,     nullptr,                    nullptr,                        0.1,   10 },
+  { "humth",      "%",        &RoomConfig::humidityThreshold, nullptr,                    nullptr,                        0.5,   50 },
+  { "soilth",     "%",        &RoomConfig::soilThreshold,     nullptr,                    nullptr,                          0,  100 },
+  { "lighton",    "h",        nullptr,                        nullptr,                    &RoomConfig::lightOnDuration,     0,   24 },
+  { "lightoff",   "h",        nullptr,                        nullptr,                    &RoomConfig::lightOffDuration,    0,   24 },
+  { "lightstart", "h",        nullptr,                        nullptr,                    &RoomConfig::lightStart,          0,   24 },
+  { "pid",        "",         nullptr,                        &RoomConfig::climateMode,   nullptr,         CLIMATE_HYSTERESIS, CLIMATE_PID },
+  { "kp",         "%/°C",     &RoomConfig::pidKp,             nullptr,                    nullptr,                          0, 1000 },
+  { "ki",         "%/°C·min", &RoomConfig::pidKi,             nullptr,                    nullptr,                          0,  100 },
+  { "kd",         "%·min/°C", &RoomConfig::pidKd,             nullptr,                    nullptr,                          0, 1000 },
+  { "humctl",     "",         nullptr,                        &RoomConfig::humidityMode,  nullptr,               HUMIDITY_OFF, HUMIDITY_VPD },
+  { "vpd",        "kPa",      &RoomConfig::vpdTarget,         nullptr,                    nullptr,                        0.2,    3 },
+  { "vpdth",      "kPa",      &RoomConfig::vpdThreshold,      nullptr,                    nullptr,                       0.01,    1 },
+};
+
+template <typename T, size_t N>
+const T *findByName(const T (&table)[N], const char *name) {
+  for (size_t i = 0; i < N; i++) if (strcasecmp(table[i].name, name) == 0) return &table[i];
+  return nullptr;
+}
+
+// A room by its own name or by one of its zones (zones share the room config)
+Room *findRoom(const char *name) {
+  for (Room *r : rooms) {
+    if (strcasecmp(r->name(), name) == 0) return r;
+    for (uint8_t z = 0; z < r->zoneCount(); z++)
+      if (strcasecmp(r->def.zones[z].name, name) == 0) return r;
+  }
+  return nullptr;
+}
+
+// ---------- Commands ----------
+typedef void (*CommandFn)(int argc, char **argv, Print &out);
+
+struct Command {
+  const char *name;
+  CommandFn   fn;
+  const char *usage;
+  const char *help;
+};
+
+void cmdHelp(int, char **, Print &out);
+void cmdStatus(int, char **, Print &out);
+void cmdSet(int argc, char **argv, Print &out);
+void cmdConfig(int argc, char **argv, Print &out);
+void cmdSave(int, char **, Print &out);
+void cmdHistory(int argc, char **argv, Print &out);
+void cmdTune(int argc, char **argv, Print &out);
+void cmdPerf(int argc, char **argv, Print &out);
+void cmdPower(int argc, char **argv, Print &out);
+void cmdSoilCal(int argc, char **argv, Print &out);
+void cmdSchedule(int, char **, Print &out);
+void cmdFloods(int, char **, Print &out);
+void cmdLog(int argc, char **argv, Print &out);
+void cmdUpdate(int, char **, Print &out);
+void cmdReboot(int, char **, Print &out);
+
+constexpr Command COMMANDS[] = {
+  { "help",     cmdHelp,     "help",                       "Show this menu" },
+  { "status",   cmdStatus,   "status",                     "Print sensor + relay data" },
+  { "set",      cmdSet,      "set <room> <param> <value>", "Change config value" },
+  { "config",   cmdConfig,   "config <room> [json]",       "Show every setting of a room" },
+  { "save",     cmdSave,     "save",                       "Save configs now (edits also auto-save)" },
+  { "history",  cmdHistory,  "history [room metric span]", "Min/avg/max, span e.g. 30m 6h 2d" },
+  { "schedule", cmdSchedule, "schedule",                   "Clock and upcoming light/flood events" },
+  { "floods",   cmdFloods,   "floods",                     "Flood queue, supply use and queue waits" },
+  { "tune",     cmdTune,     "tune <room> [stop]",         "Relay auto-tune of the room's PID gains" },
+  { "perf",     cmdPerf,     "perf [reset]",               "Stage timings: avg/p99/max µs, late, missed" },
+  { "power",    cmdPower,    "power [reset]",              "Sleep mode, wakeups and busy time per task" },
+  { "soilcal",  cmdSoilCal,  "soilcal [pin <point>]",      "Soil probes; point: dry, wet, %, weight n, clear" },
+  { "log",      cmdLog,      "log [level|text|binary]",    "Log level/format, drop and rate-limit counts" },
+  { "update",   cmdUpdate,   "update",                     "Perform OTA update from GitHub" },
+  { "reboot",   cmdReboot,   "reboot",                     "Restart ESP32" },
+  { "start",    cmdHelp,     nullptr,                      nullptr },   // Telegram /start
+};
+
+// A reboot waits briefly so its reply can reach the transport first
+bool restartPending = false;
+unsigned long restartAt = 0;
+
+void cmdHelp(int, char **, Print &out) {
+  out.println("========== GREENHOUSE CONSOLE ==========");
+  for (const Command &c : COMMANDS)
+    if (c.usage) cmdPrintf(out, "%-26s - %s\n", c.usage, c.help);
+  out.print("   room:");
+  for (Room *r : rooms) {
+    cmdPrintf(out, " %s", r->name());
+    for (uint8_t z = 0; z < r->zoneCount(); z++)
+      if (strcasecmp(r->def.zones[z].name, r->name())) cmdPrintf(out, " %s", r->def.zones[z].name);
+  }
+  out.print("\n   param:");
+  for (const ConfigParam &p : CONFIG_PARAMS) cmdPrintf(out, " %s", p.name);
+  out.println("\n----------------------------------------");
+}
+
+void showHelp() { cmdHelp(0, nullptr, Serial); }
+
+void cmdStatus(int, char **, Print &out) {
+  for (Room *r : rooms) {
+    cmdPrintf(out, "%s: %.1f°C %.1f%% -> Temp %.1f Hum %.1f\n", r->cfg.name.c_str(),
+              r->lastTemp, r->lastHum, r->cfg.idealTemp, r->cfg.idealHumidity);
+    if (r->cfg.humidityMode == HUMIDITY_VPD)
+      cmdPrintf(out, "  VPD %.2f kPa -> %.2f\n", r->lastVpd, r->cfg.vpdTarget);
+    for (uint8_t z = 0; z < r->zoneCount(); z++)
+      cmdPrintf(out, "  %s soil %.1f%% -> %.1f%%\n", r->def.zones[z].name, r->zoneSoil(z), r->zoneTarget(z));
+    if (r->autotune().running())
+      cmdPrintf(out, "  climate auto-tune, oscillation %u of %u\n", r->autotune().cycles, TUNE_CYCLES + 1);
+    else if (r->cfg.climateMode == CLIMATE_PID)
+      cmdPrintf(out, "  climate PID, %s %d%%\n", r->climateOutput < 0 ? "exhaust" : "heater",
+                abs(r->climateOutput) / 10);
+  }
+}
+
+void cmdSet(int argc, char **argv, Print &out) {
+  if (argc != 4) { out.println("Format: set <room> <param> <value>"); return; }
+
+  Room *room = findRoom(argv[1]);
+  if (!room) { out.println("Unknown room. Type 'help' for list."); return; }
+
+  const ConfigParam *p = findByName(CONFIG_PARAMS, argv[2]);
+  if (!p) { out.println("Unknown param. Type 'help' for list."); return; }
+
+  char *end;
+  float value = strtof(argv[3], &end);
+  if (end == argv[3] || *end || !isfinite(value)) { out.println("Value must be a number"); return; }
+  if (value < p->lo || value > p->hi || (p->i && value != (int)value)) {
+    cmdPrintf(out, "❌ %s must be %s%g to %g%s%s\n", p->name, p->i ? "a whole number, " : "",
+              p->lo, p->hi, *p->unit ? " " : "", p->unit);
+    return;
+  }
+
+  RoomConfig &cfg = room->cfg;
+  if (p->f)          cfg.*(p->f) = value;
+  else if (p->i)     cfg.*(p->i) = (int)value;
+  else if (p->hours) cfg.*(p->hours) = (unsigned long)(value * 3600000.0f);
+
+  room->planLighting();  // light times may have moved
+  configStore.touch();   // saved once edits stop for CONFIG_SAVE_DELAY_MS
+  cmdPrintf(out, "✅ Set %s %s = %.2f%s\n", room->name(), p->name, value, p->unit);
+}
+
+// Plain lines for people, one JSON object for the dashboard's REST API
+void cmdConfig(int argc, char **argv, Print &out) {
+  if (argc < 2) { out.println("Format: config <room> [json]"); return; }
+  Room *room = findRoom(argv[1]);
+  if (!room) { out.println("Unknown room. Type 'help' for list."); return; }
+  bool json = argc > 2 && !strcasecmp(argv[2], "json");
+
+  const RoomConfig &cfg = room->cfg;
+  if (json) cmdPrintf(out, "{\"room\":\"%s\"", room->name());
+  else cmdPrintf(out, "%s (%s)\n", cfg.name.c_str(), room->name());
+  for (const ConfigParam &p : CONFIG_PARAMS) {
+    float value = p.f ? cfg.*(p.f) : p.i ? (float)(cfg.*(p.i)) : cfg.*(p.hours) / 3600000.0f;
+    if (json) cmdPrintf(out, ",\"%s\":%g", p.name, value);
+    else cmdPrintf(out, "  %-10s %8.2f %s\n", p.name, value, p.unit);
+  }
+  if (json) out.println("}");
+}
+
+void cmdSave(int, char **, Print &out) {
+  switch (configStore.flush()) {
+    case ConfigStore::SAVE_WRITTEN:   out.println("✅ Configs saved to NVS."); break;
+    case ConfigStore::SAVE_UNCHANGED: out.println("✅ Configs already up to date."); break;
+    case ConfigStore::SAVE_FAILED:    out.println("❌ Saving configs failed."); break;
+  }
+}
+
+// "90" (minutes), "30m", "6h" or "2d" in seconds; 0 if malformed
+uint32_t parseSpan(const char *s) {
+  char *end;
+  long n = strtol(s, &end, 10);
+  if (end == s || n <= 0 || (*end && end[1])) return 0;
+  switch (tolower(*end)) {
+    case '\0':
+    case 'm': return n * 60UL;
+    case 'h': return n * 3600UL;
+    case 'd': return n * 86400UL;
+  }
+  return 0;
+}
+
+void fmtSpan(char *buf, size_t len, uint32_t sec) {
+  if (sec >= 86400)    snprintf(buf, len, "%lud%02luh", (unsigned long)sec / 86400, (unsigned long)sec % 86400 / 3600);
+  else if (sec >= 3600) snprintf(buf, len, "%luh%02lum", (unsigned long)sec / 3600, (unsigned long)sec % 3600 / 60);
+  else                 snprintf(buf, len, "%lum%02lus", (unsigned long)sec / 60, (unsigned long)sec % 60);
+}
+
+void cmdHistory(int argc, char **argv, Print &out) {
+  char a[16], b[16], c[16];
+  if (argc < 3) {
+    out.println("Series:");
+    const char *owner = nullptr;
+    for (uint8_t i = 0; i < history.size(); i++) {
+      const HistoryChannel &ch = history.channel(i);
+      if (!owner || strcmp(owner, ch.owner)) {
+        if (owner) out.println();
+        owner = ch.owner;
+        cmdPrintf(out, "  %s:", owner);
+      }
+      cmdPrintf(out, " %s", ch.metric);
+    }
+    fmtSpan(a, sizeof(a), history.rawSpan());
+    fmtSpan(b, sizeof(b), history.minuteSpan());
+    fmtSpan(c, sizeof(c), history.hourSpan());
+    cmdPrintf(out, "\nKept: raw %s, minutes %s, hours %s\n", a, b, c);
+    return;
+  }
+
+  int id = history.find(argv[1], argv[2]);
+  if (id < 0) { out.println("Unknown series. Type 'history' for list."); return; }
+  uint32_t span = argc > 3 ? parseSpan(argv[3]) : 3600;
+  if (!span) { out.println("Span like 30m, 6h or 2d"); return; }
+
+  const HistoryChannel &ch = history.channel(id);
+  RollupAccum rows[HISTORY_ROWS];
+  uint32_t bucket;
+  const char *tier = history.query(id, span, rows, bucket);
+  int prec = History::precision(ch);
+
+  fmtSpan(a, sizeof(a), span);
+  fmtSpan(b, sizeof(b), bucket);
+  cmdPrintf(out, "📈 %s %s (%s), last %s, %s per row from %s data\n",
+            ch.owner, ch.metric, History::unit(ch), a, b, tier);
+  for (uint8_t i = 0; i < HISTORY_ROWS; i++) {
+    if (!rows[i].n) continue;
+    fmtSpan(a, sizeof(a), span - i * bucket);
+    cmdPrintf(out, "  -%-7s min %.*f  avg %.*f  max %.*f\n", a,
+              prec, History::toUnits(ch, rows[i].min),
+              prec, History::toUnits(ch, rows[i].sum / rows[i].n),
+              prec, History::toUnits(ch, rows[i].max));
+  }
+}
+
+void cmdTune(int argc, char **argv, Print &out) {
+  if (argc < 2) { out.println("Format: tune <room> [stop]"); return; }
+  Room *room = findRoom(argv[1]);
+  if (!room) { out.println("Unknown room. Type 'help' for list."); return; }
+  if (argc > 2 && !strcasecmp(argv[2], "stop")) {
+    room->stopAutotune();
+    out.println("✅ Auto-tune stopped");
+  } else if (room->startAutotune()) {
+    cmdPrintf(out, "🎛️ Tuning %s: the heater cycles around %.1f°C for an hour or more,\n"
+                   "the gains are saved and PID switched on when it finishes\n",
+              room->name(), room->cfg.idealTemp);
+  } else {
+    out.println("❌ Room has no heater to tune with");
+  }
+}
+
+#define SCHEDULE_LIST_MAX 12
+
+void cmdSchedule(int, char **, Print &out) {
+  uint64_t now = millis64(), wall;
+  bool timed = halWallMs(wall);
+  uint32_t sod = timed ? wall / 1000 % 86400 : 0;
+  if (timed) cmdPrintf(out, "Clock %02lu:%02lu:%02lu local, lights follow the time of day\n",
+                       (unsigned long)sod / 3600, (unsigned long)sod % 3600 / 60, (unsigned long)sod % 60);
+  else out.println("Clock not set, schedules run on uptime");
+
+  // soonest first; the wheel itself is unordered
+  const WheelEvent *list[SCHEDULE_LIST_MAX];
+  uint8_t n = 0;
+  timerWheel.forEach([&](const WheelEvent &e) {
+    uint8_t i = n < SCHEDULE_LIST_MAX ? n++ : SCHEDULE_LIST_MAX;
+    while (i > 0 && list[i - 1]->dueMs > e.dueMs) {
+      if (i < SCHEDULE_LIST_MAX) list[i] = list[i - 1];
+      i--;
+    }
+    if (i < SCHEDULE_LIST_MAX) list[i] = &e;
+  });
+
+  char in[16];
+  for (uint8_t i = 0; i < n; i++) {
+    const WheelEvent &e = *list[i];
+    uint32_t sec = e.dueMs > now ? (e.dueMs - now + 999) / 1000 : 0;
+    fmtSpan(in, sizeof(in), sec);
+    if (timed) {
+      uint32_t at = (sod + sec) % 86400;
+      cmdPrintf(out, "  %02lu:%02lu  in %-7s %-8s %s\n", (unsigned long)at / 3600,
+                (unsigned long)at % 3600 / 60, in, e.owner, e.what);
+    } else {
+      cmdPrintf(out, "  in %-7s %-8s %s\n", in, e.owner, e.what);
+    }
+  }
+  cmdPrintf(out, "%u events armed, %lu fired\n", timerWheel.size(), (unsigned long)timerWheel.firedCount());
+}
+
+void cmdFloods(int, char **, Print &out) {
+  cmdPrintf(out, "Supply %u/%u floods, %u/%u mA (peak %u floods, %u mA)\n",
+            irrigation.running(), IRR_MAX_ACTIVE, irrigation.runningMa(), IRR_SUPPLY_MA,
+            irrigation.peakRunning(), irrigation.peakCurrent());
+
+  // grant order
+  FloodRequest queue[IRR_QUEUE_MAX];
+  uint8_t n = irrigation.snapshot(queue);
+  uint64_t now = millis64();
+  char a[16], b[16];
+  for (uint8_t i = 0; i < n; i++) {
+    const FloodRequest &r = queue[i];
+    fmtSpan(a, sizeof(a), (uint32_t)((now - r.submittedMs) / 1000));
+    cmdPrintf(out, "  %u. %-8s dry %4.1f%% %4u mA  waiting %s%s\n", i + 1, r.name, r.priority / 10.0,
+              r.currentMa, a, now >= r.deadlineMs ? "  overdue" : "");
+  }
+  if (!n) out.println("  queue empty");
+
+  for (uint8_t i = 0; i < irrigation.statCount(); i++) {
+    const FloodWaitStats &s = irrigation.stat(i);
+    fmtSpan(a, sizeof(a), (uint32_t)(s.totalWaitMs / s.grants / 1000));
+    fmtSpan(b, sizeof(b), s.maxWaitMs / 1000);
+    cmdPrintf(out, "  %-8s %lu floods, wait avg %s max %s, %lu past deadline\n", s.name,
+              (unsigned long)s.grants, a, b, (unsigned long)s.late);
+  }
+}
+
+#if PERF_ENABLED
+void cmdPerf(int argc, char **argv, Print &out) {
+  if (argc > 1 && !strcasecmp(argv[1], "reset")) {
+    perf.reset();
+    out.println("✅ Perf counters cleared");
+    return;
+  }
+  out.println("stage        runs    avg    p99    max  late99  miss");
+  for (uint8_t i = 0; i < perf.size(); i++) {
+    const PerfStat &s = perf.stat(i);
+    if (!s.runs) continue;
+    cmdPrintf(out, "%-9s %7lu %6lu %6lu %6lu", s.name, (unsigned long)s.runs,
+              (unsigned long)(s.totalUs / s.runs), (unsigned long)s.p99(), (unsigned long)s.maxUs);
+    if (s.scheduled) cmdPrintf(out, "  %6lu %5lu\n", (unsigned long)s.late.percentile(s.runs, 99),
+                               (unsigned long)s.missed);
+    else out.println("       -     -");
+  }
+  out.println("(µs; p99 is a log2 bucket edge)");
+}
+#else
+void cmdPerf(int, char **, Print &out) {
+  out.println("Perf counters compiled out (PERF_ENABLED 0)");
+}
+#endif
+
+void cmdPower(int argc, char **argv, Print &out) {
+  if (argc > 1 && !strcasecmp(argv[1], "reset")) {
+    power.reset();
+    out.println("✅ Power counters cleared");
+    return;
+  }
+  cmdPrintf(out, "Mode %s, CPU %lu MHz%s%s\n", power.enabled ? "power save" : "full speed",
+            (unsigned long)halCpuMhz(), power.lightSleep ? ", light-sleep" : "",
+            power.uartWake ? ", serial wakes" : "");
+  double secs = power.seconds();
+  if (secs < 1) return;
+  double busy = 0;
+  out.println("task      wakes/s  busy");
+  for (uint8_t i = 0; i < power.taskCount(); i++) {
+    const PowerTask &t = power.task(i);
+    double pct = t.busyMs / (secs * 10);
+    busy += pct;
+    cmdPrintf(out, "%-8s %8.1f %4.1f%%\n", t.name, t.wakes / secs, pct);
+  }
+  if (busy > 100) busy = 100;
+  // without light-sleep the spare time is spent in the idle task at full clock
+  cmdPrintf(out, "Over %.0f s: active <= %.1f%%, %s >= %.1f%% (estimate)\n", secs, busy,
+            power.lightSleep ? "asleep" : "idle", 100 - busy);
+}
+
+// Every probe by room and zone: counts, moisture, weight and curve points
+void soilCalList(Print &out) {
+  for (Room *r : rooms)
+    for (uint8_t z = 0; z < r->zoneCount(); z++) {
+      const ZoneDef &zd = r->def.zones[z];
+      cmdPrintf(out, "%s/%s: %.1f%%\n", r->name(), zd.name, r->zoneSoil(z));
+      for (uint8_t i = zd.firstProbe; i < zd.firstProbe + zd.probeCount; i++) {
+        int pin = r->def.soilPins[i];
+        const SoilCalPoint *pts;
+        uint8_t n = soilCal.points(pin, pts);
+        cmdPrintf(out, "  pin %-2d %6.0f  %5.1f%%  w%u  ", pin, soilSensors.value(pin),
+                  soilSensors.moisture(pin), soilSensors.weight(pin));
+        if (n < 2) out.print(n ? "default curve +" : "default curve");
+        for (uint8_t k = 0; k < n; k++) cmdPrintf(out, " %u=%.1f%%", pts[k].raw, pts[k].permille / 10.0);
+        out.println();
+      }
+    }
+}
+
+void cmdSoilCal(int argc, char **argv, Print &out) {
+  if (argc < 2) { soilCalList(out); return; }
+  if (argc < 3) { out.println("Format: soilcal <pin> dry|wet|<pct>|weight <0-9>|clear"); return; }
+
+  char *end;
+  int pin = strtol(argv[1], &end, 10);
+  if (end == argv[1] || *end || !soilSensors.known(pin)) { out.println("Unknown probe pin. Type 'soilcal' for list."); return; }
+
+  SoilCalibration::Result res;
+  if (!strcasecmp(argv[2], "clear")) {
+    res = soilCal.clear(pin);
+  } else if (!strcasecmp(argv[2], "weight")) {
+    long w = argc > 3 ? strtol(argv[3], &end, 10) : -1;
+    if (w < 0 || w > SOIL_WEIGHT_MAX || *end) { cmdPrintf(out, "Weight must be 0-%d\n", SOIL_WEIGHT_MAX); return; }
+    res = soilCal.setWeight(pin, w);
+  } else {
+    float pct;
+    if (!strcasecmp(argv[2], "dry")) pct = 0;
+    else if (!strcasecmp(argv[2], "wet")) pct = SOIL_CAL_WET_PCT;
+    else {
+      pct = strtof(argv[2], &end);
+      if (end == argv[2] || *end) pct = NAN;
+    }
+    if (!(pct >= 0 && pct <= 100)) {
+      out.println("Moisture must be dry, wet or 0-100");
+      return;
+    }
+    res = soilCal.capture(pin, (uint16_t)lroundf(pct * 10));
+  }
+
+  switch (res) {
+    case SoilCalibration::CAL_OK:            cmdPrintf(out, "✅ Probe %d now reads %.1f%%\n", pin, soilSensors.moisture(pin)); break;
+    case SoilCalibration::CAL_NO_READING:    out.println("❌ Probe has no healthy reading to capture"); break;
+    case SoilCalibration::CAL_FULL:          cmdPrintf(out, "❌ Probe already has %d points, clear it first\n", SOIL_CAL_POINTS); break;
+    case SoilCalibration::CAL_NOT_MONOTONIC: out.println("❌ Moisture must rise (or fall) with the counts across all points"); break;
+    case SoilCalibration::CAL_SAVE_FAILED:   out.println("⚠️ Applied, but not saved to flash"); break;
+    default:                                 out.println("Unknown probe pin"); break;
+  }
+}
+
+void cmdLog(int argc, char **argv, Print &out) {
+  LogLevel lvl;
+  if (argc > 1) {
+    if (!strcasecmp(argv[1], "binary"))    logger.binary = true;
+    else if (!strcasecmp(argv[1], "text")) logger.binary = false;
+    else if (Logger::parseLevel(argv[1], lvl)) logger.level = lvl;
+    else { out.println("❌ Use: log [error|warn|info|debug|text|binary]"); return; }
+  }
+  cmdPrintf(out, "Log %s, %s  written %lu  dropped %lu  pending %lu\n",
+            LOG_LEVEL_NAMES[logger.level], logger.binary ? "binary" : "text",
+            (unsigned long)logger.writtenCount(), (unsigned long)logger.droppedCount(),
+            (unsigned long)logger.pendingCount());
+  for (uint8_t i = 0; i < logger.size(); i++) {
+    const LogSource &s = logger.source(i);
+    cmdPrintf(out, "  %-8s suppressed %lu\n", s.name, (unsigned long)s.suppressed);
+  }
+}
+
+void cmdUpdate(int, char **, Print &out) {
+  if (!netTaskRunning) { out.println("❌ Network task not running"); return; }
+  out.println("⬇️ Fetching latest firmware from GitHub...");
+  otaRequested = true;   // OTA runs on the network core, never here
+}
+
+void cmdReboot(int, char **, Print &out) {
+  out.println("♻️ Rebooting...");
+  restartPending = true;
+  restartAt = millis() + 1500;
+}
+
+// Tokenise in place and dispatch one line. Leading '/' (Telegram) is ignored.
+void runCommand(char *line, Print &out) {
+  if (*line == '/') line++;
+
+  char *argv[CMD_MAX_ARGS];
+  int argc = 0;
+  char *save = nullptr;
+  for (char *tok = strtok_r(line, " \t", &save); tok; tok = strtok_r(nullptr, " \t", &save)) {
+    if (argc == CMD_MAX_ARGS) { out.println("Too many arguments"); return; }
+    argv[argc++] = tok;
+  }
+  if (argc == 0) return;
+
+  const Command *c = findByName(COMMANDS, argv[0]);
+  if (c) c->fn(argc, argv, out);
+  else out.println("Unknown command. Type 'help' for list.");
+}
+
+// ---------- Transports ----------
+// Collects text for the network task to send back as one message.
+class ReplyBuffer : public Print {
+public:
+  ReplyMsg msg;
+  size_t   len = 0;
+
+  ReplyBuffer() { msg.text[0] = '\0'; }
+
+  size_t write(uint8_t c) override {
+    if (len >= sizeof(msg.text) - 1) return 0;
+    msg.text[len++] = c;
+    msg.text[len] = '\0';
+    return 1;
+  }
+  using Print::write;
+};
+
+LineBuffer serialLine;
+
+// One reply per command, even an empty one, so the sender stops waiting
+template <size_t N, size_t M>
+void serveQueue(SpscQueue<CommandMsg, N> &in, SpscQueue<ReplyMsg, M> &out) {
+  CommandMsg cmd;
+  while (in.pop(cmd)) {
+    ReplyBuffer reply;
+    runCommand(cmd.text, reply);
+    out.push(reply.msg);
+  }
+}
+
+void handleSerial() {
+  while (Serial.available())
+    if (serialLine.feed((char)Serial.read())) runCommand(serialLine.text, Serial);
+
+  serveQueue(commandQueue, replyQueue);           // Telegram
+  serveQueue(webCommandQueue, webReplyQueue);     // dashboard REST calls
+  serveQueue(mqttCommandQueue, mqttReplyQueue);   // MQTT command topic
+
+  if (restartPending && (long)(millis() - restartAt) >= 0) {
+    configStore.flush();   // don't lose edits still waiting out the save delay
+    resumeStore.checkpoint();
+    ESP.restart();
+  }
+}
+
+#endif
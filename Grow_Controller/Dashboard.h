@@ -0,0 +1,250 @@
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include "HttpServer.h"
+#include "Link.h"
+#include "Rooms.h"
+
+#define WEB_PORT           80
+#define WEB_WS_PATH        "/ws"
+#define WEB_PUSH_MS        1000   // WebSocket telemetry at most this often
+#define WEB_REPLY_WAIT_MS  2000   // REST calls answered by the control task give up after this
+#define WEB_PENDING_MAX    4      // REST calls in flight; webReplyQueue must hold them all
+
+static_assert(WEB_PENDING_MAX <= 4, "webReplyQueue could overflow");
+
+// ---------- Page ----------
+// Served straight from flash; everything live comes over the WebSocket.
+const char DASHBOARD_PAGE[] = R"HTML(<!doctype html>
+<html><head><meta charset="utf-8"><meta name="viewport" content="width=device-width,initial-scale=1">
+<title>Grow Controller</title>
+<style>
+body{font:15px system-ui,sans-serif;margin:1em;background:#111;color:#ddd}
+.room{border:1px solid #444;border-radius:6px;padding:.4em 1em;margin:.6em 0}
+h2{margin:.2em 0;font-size:1.1em}.on{color:#6d6}.off{color:#666}#state{color:#888}
+input{width:6em}
+</style></head><body>
+<h1>🌿 Grow Controller</h1><div id="state">connecting…</div><div id="rooms"></div>
+<form id="set">Set <input id="room" placeholder="room"> <input id="param" placeholder="param">
+<input id="value" placeholder="value"> <button>Apply</button> <span id="reply"></span></form>
+<script>
+const $=id=>document.getElementById(id);
+const num=(v,d)=>v===null?'–':v.toFixed(d);
+function show(t){
+  $('rooms').innerHTML=t.rooms.map(r=>'<div class="room"><h2>'+r.title+'</h2>'+
+    (r.sensor?num(r.temp,1)+' °C · '+num(r.hum,1)+' %':'sensor offline')+
+    '<br>Soil '+Object.entries(r.zones).map(([z,v])=>z+' '+num(v,1)+' %').join(' · ')+'<br>'+
+    Object.entries(r.relays).map(([n,on])=>'<span class="'+(on?'on':'off')+'">'+n+'</span>').join(' ')+
+    '</div>').join('');
+  $('state').textContent='up '+t.uptime+' s';
+}
+function connect(){
+  const ws=new WebSocket('ws://'+location.host+'/ws');
+  ws.onmessage=e=>show(JSON.parse(e.data));
+  ws.onclose=()=>{$('state').textContent='reconnecting…';setTimeout(connect,2000);};
+}
+connect();
+$('set').onsubmit=async e=>{
+  e.preventDefault();
+  const r=await fetch('/api/config/'+encodeURIComponent($('room').value),
+                      {method:'POST',body:$('param').value+'='+$('value').value});
+  $('reply').textContent=await r.text();
+};
+</script></body></html>
+)HTML";
+
+// ---------- Web dashboard ----------
+// Runs in the web task, never on the control core. Live readings come in
+// through webTelemetryQueue and go out to every WebSocket client as one
+// shared JSON frame per second. REST calls that read or change settings
+// become console commands on webCommandQueue and are answered when the
+// control task's reply arrives, so the rooms' RoomConfig is only ever
+// touched by the control task.
+//
+//   GET  /                    the dashboard page
+//   GET  /ws                  WebSocket, a telemetry frame every WEB_PUSH_MS
+//   GET  /api/telemetry       the latest frame
+//   GET  /api/relays          relay states per room (RelayController::states())
+//   GET  /api/config/<room>   every setting of a room, as `config <room> json`
+//   POST /api/config/<room>   body "param=value", as `set <room> param value`
+
+class Dashboard {
+public:
+  HttpServer server;
+
+  bool begin(uint16_t port) { return server.begin(port, onRequest, this, WEB_WS_PATH); }
+  bool listening() const { return server.listening(); }
+
+  // Web task: take new readings and replies, then serve sockets for up to waitMs
+  void poll(uint32_t waitMs) {
+    Telemetry t;
+    bool fresh = false;
+    while (webTelemetryQueue.pop(t)) { latest = t; fresh = true; }
+    uint64_t now = millis64();
+    if (fresh) {
+      haveTelemetry = true;
+      if (now - lastPush >= WEB_PUSH_MS) {
+        lastPush = now;
+        server.broadcast(telemetryFrame());
+      }
+    }
+
+    ReplyMsg reply;
+    while (webReplyQueue.pop(reply)) answer(reply);
+    for (uint8_t i = 0; i < pendingCount; i++) {
+      Pending &p = pending[(pendingHead + i) % WEB_PENDING_MAX];
+      if (p.timedOut || now - p.sentMs < WEB_REPLY_WAIT_MS) continue;
+      server.respondText(p.id, 504, "controller did not answer");
+      p.timedOut = true;   // stays queued until its late reply is taken
+    }
+
+    server.poll(waitMs);
+  }
+
+private:
+  // REST calls waiting for the control task, in command order
+  struct Pending {
+    uint16_t id;
+    bool     json;       // config read: the reply is the body
+    bool     timedOut;
+    uint64_t sentMs;
+  };
+
+  Telemetry latest = {};
+  bool      haveTelemetry = false;
+  uint64_t  lastPush = 0;
+  Pending   pending[WEB_PENDING_MAX];
+  uint8_t   pendingHead = 0, pendingCount = 0;
+
+  static void onRequest(void *ctx, const HttpRequest &req) { static_cast<Dashboard *>(ctx)->route(req); }
+
+  void route(const HttpRequest &req) {
+    bool get = !strcmp(req.method, "GET"), post = !strcmp(req.method, "POST");
+    char room[16];
+
+    if (!strcmp(req.path, "/")) {
+      if (!get) { server.respondText(req.id, 405, "GET only"); return; }
+      server.respondStatic(req.id, 200, "text/html; charset=utf-8", DASHBOARD_PAGE, strlen(DASHBOARD_PAGE));
+    } else if (!strcmp(req.path, "/api/telemetry") || !strcmp(req.path, "/api/relays")) {
+      if (!get) { server.respondText(req.id, 405, "GET only"); return; }
+      if (!haveTelemetry) { server.respondText(req.id, 503, "no readings yet"); return; }
+      bool all = !strcmp(req.path, "/api/telemetry");
+      server.respond(req.id, 200, "application/json", all ? telemetryFrame() : relaysFrame());
+    } else if (!strncmp(req.path, "/api/config/", 12) && token(req.path + 12, room, sizeof(room))) {
+      if (get) {
+        forward(req.id, true, "config %s json", room);
+      } else if (post) {
+        char param[16], value[16];
+        const char *eq = strchr(req.body, '=');
+        if (!eq || !token(req.body, param, sizeof(param), '=') || !token(eq + 1, value, sizeof(value))) {
+          server.respondText(req.id, 400, "body must be param=value");
+          return;
+        }
+        forward(req.id, false, "set %s %s %s", room, param, value);
+      } else {
+        server.respondText(req.id, 405, "GET or POST");
+      }
+    } else {
+      server.respondText(req.id, 404, req.path);
+    }
+  }
+
+  // Copy a room, param or value up to `stop`; only characters that cannot
+  // smuggle extra console arguments, and trailing whitespace is dropped
+  static bool token(const char *s, char *out, size_t len, char stop = '\0') {
+    size_t n = 0;
+    for (; *s && *s != stop && !isspace((unsigned char)*s); s++) {
+      if (!isalnum((unsigned char)*s) && !strchr("._-", *s)) return false;
+      if (n + 1 >= len) return false;
+      out[n++] = *s;
+    }
+    while (*s && *s != stop) if (!isspace((unsigned char)*s++)) return false;
+    out[n] = '\0';
+    return n > 0;
+  }
+
+  void forward(uint16_t id, bool json, const char *fmt, ...) __attribute__((format(printf, 4, 5))) {
+    CommandMsg cmd;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(cmd.text, sizeof(cmd.text), fmt, ap);
+    va_end(ap);
+    if (pendingCount == WEB_PENDING_MAX || !webCommandQueue.push(cmd)) {
+      server.respondText(id, 503, "controller busy, try again");
+      return;
+    }
+    pending[(pendingHead + pendingCount++) % WEB_PENDING_MAX] = { id, json, false, millis64() };
+  }
+
+  void answer(const ReplyMsg &reply) {
+    if (!pendingCount) return;
+    Pending p = pending[pendingHead];
+    pendingHead = (pendingHead + 1) % WEB_PENDING_MAX;
+    pendingCount--;
+    if (p.timedOut) return;
+
+    size_t n = strlen(reply.text);
+    while (n && isspace((unsigned char)reply.text[n - 1])) n--;
+    // the engine answers a bad room or param in plain text, a good edit with ✅
+    bool ok = p.json ? reply.text[0] == '{' : !strncmp(reply.text, "✅", strlen("✅"));
+    SharedFrame *f = server.pool.acquire();
+    if (f) f->append(reply.text, n);
+    server.respond(p.id, ok ? 200 : 400, ok && p.json ? "application/json" : "text/plain; charset=utf-8", f);
+  }
+
+  static void number(SharedFrame *f, const char *key, float v, int decimals) {
+    if (isnan(v)) f->appendf("\"%s\":null", key);
+    else f->appendf("\"%s\":%.*f", key, decimals, v);
+  }
+
+  static void relays(SharedFrame *f, uint8_t room, uint32_t states) {
+    char sep = '{';
+    for (uint8_t ch = 0; ch < ROOM_RELAY_COUNT; ch++) {
+      if (ROOM_TABLE[room].relayPins[ch] == NO_PIN) continue;
+      f->appendf("%c\"%s\":%s", sep, relayLabel(room, ch), states >> ch & 1 ? "true" : "false");
+      sep = ',';
+    }
+    f->append("}", 1);
+  }
+
+  SharedFrame *telemetryFrame() {
+    SharedFrame *f = server.pool.acquire();
+    if (!f) return nullptr;
+    f->appendf("{\"uptime\":%lu,\"rooms\":[", latest.stamp / 1000);
+    for (uint8_t i = 0; i < latest.roomCount && i < ROOM_COUNT; i++) {
+      const RoomDef &d = ROOM_TABLE[i];
+      const RoomTelemetry &rt = latest.rooms[i];
+      f->appendf("%s{\"name\":\"%s\",\"title\":\"%s\",\"sensor\":%s,", i ? "," : "", d.name, d.title,
+                 rt.sensorOk ? "true" : "false");
+      number(f, "temp", rt.temp, 1);
+      f->append(",", 1);
+      number(f, "hum", rt.hum, 1);
+      f->append(",\"zones\":{", 10);
+      for (uint8_t z = 0; z < d.zoneCount; z++) {
+        if (z) f->append(",", 1);
+        number(f, d.zones[z].name, rt.soil[z], 1);
+      }
+      f->append("},\"relays\":", 11);
+      relays(f, i, rt.relays);
+      f->append("}", 1);
+    }
+    f->append("]}", 2);
+    return f;
+  }
+
+  SharedFrame *relaysFrame() {
+    SharedFrame *f = server.pool.acquire();
+    if (!f) return nullptr;
+    for (uint8_t i = 0; i < latest.roomCount && i < ROOM_COUNT; i++) {
+      f->appendf("%c\"%s\":", i ? ',' : '{', ROOM_TABLE[i].name);
+      relays(f, i, latest.rooms[i].relays);
+    }
+    f->append("}", 1);
+    return f;
+  }
+};
+
+extern Dashboard dashboard;
+
+
+#endif
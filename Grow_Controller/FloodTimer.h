@@ -0,0 +1,72 @@
+#ifndef FLOODTIMER_H
+#define FLOODTIMER_H
+
+#include <atomic>
+#include <stdlib.h>
+#include "Hal.h"
+
+// ---------- Hardware-timed flood shutoff ----------
+// start() arms a one-shot timer as the pump or solenoid switches on. When
+// it expires the callback clears the output pin itself, so the dose does
+// not depend on the control loop being responsive. The room sees fired()
+// on its next flood check and updates its own state; commanded and actual
+// durations are kept per zone.
+class FloodTimer {
+public:
+  unsigned long floods = 0;
+  uint32_t lastCommandedMs = 0;
+  uint32_t lastActualMs = 0;
+  int32_t  worstErrorMs = 0;   // largest actual - commanded seen so far
+
+  void begin(const char *name) { handle = oneShotCreate(onExpire, this, name); }
+
+  // Call right after the output went high. False if the timer did not
+  // arm (no pin, or no timer): the caller has to end the flood itself.
+  bool start(int pin, uint32_t durationMs) {
+    commandedMs = durationMs;
+    expired.store(false);
+    startUs = halMicros64();
+    if (pin < 0 || pin >= 64) return false;
+    pinMask = 1ULL << pin;
+    return oneShotStart(handle, (uint64_t)durationMs * 1000);
+  }
+
+  // true once after the timer cut the output
+  bool fired() {
+    if (!expired.exchange(false, std::memory_order_acquire)) return false;
+    record(offUs);
+    return true;
+  }
+
+  // Flood ended by the software backstop instead
+  void stop() {
+    oneShotStop(handle);
+    expired.store(false);
+    record(halMicros64());
+  }
+
+private:
+  OneShotHandle handle = ONESHOT_NONE;
+  uint64_t pinMask = 0;
+  uint64_t startUs = 0;
+  uint64_t offUs = 0;
+  uint32_t commandedMs = 0;
+  std::atomic<bool> expired{false};
+
+  static void onExpire(void *arg) {
+    FloodTimer *t = (FloodTimer *)arg;
+    gpioWriteMasks(0, t->pinMask);
+    t->offUs = halMicros64();
+    t->expired.store(true, std::memory_order_release);
+  }
+
+  void record(uint64_t endUs) {
+    floods++;
+    lastCommandedMs = commandedMs;
+    lastActualMs = (uint32_t)((endUs - startUs) / 1000);
+    int32_t err = (int32_t)lastActualMs - (int32_t)commandedMs;
+    if (abs(err) > abs(worstErrorMs)) worstErrorMs = err;
+  }
+};
+
+#endif
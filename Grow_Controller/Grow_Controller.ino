@@ -1,76 +1,283 @@
 #include "Config.h"
 #include "RoomBase.h"
-#include "VegRoom.h"
-#include "FlowerRoom.h"
+#include "Rooms.h"
 #include "Console.h"
+#include "ConfigStore.h"
+#include "History.h"
+#include "Scheduler.h"
+#include "Link.h"
+#include "ClimateSensor.h"
+#include "Log.h"
+#include "ResumeState.h"
+#include "TimerWheel.h"
+#include "Power.h"
+#include "SoilCalibration.h"
 #include <Preferences.h>
 
 // ------------------------------------------------------------------
 // Optional Telegram interface
 // ------------------------------------------------------------------
-#define USE_TELEGRAM  true   // set to false to disable all WiFi/Telegram features
+#define USE_TELEGRAM  true   // set to false to disable all WiFi/Telegram/dashboard/MQTT features
 #if USE_TELEGRAM
-  #include "TelegramBot.h"
+  #include "NetTask.h"
 #endif
 // ------------------------------------------------------------------
 
-Adafruit_AHTX0 aht;
 Preferences prefs;
+ConfigStore configStore;
+History history;
+PerfRegistry perf;
+Logger logger;
+RTC_NOINIT_ATTR ResumeImage resumeRtc;   // survives every reset but power loss
+ResumeStore resumeStore;
+LogSource logControl("control");
+SoilSensors soilSensors;
+SoilCalibration soilCal;
 
+// One controller per ROOM_TABLE row, in the same order
 VegRoom vegRoom;
 FlowerRoom flowerRoom;
+Room *const rooms[ROOM_COUNT] = { &vegRoom, &flowerRoom };
+
+Scheduler scheduler;
+TimerWheel timerWheel;   // light edges and flood rest periods
+PowerManager power;
+PowerTask powerControl, powerLog;
+int consoleTask = -1;   // scheduler id, pulled forward by serial input
+IrrigationScheduler irrigation;   // one flood supply shared by every zone
+
+// Control <-> network queues (see Link.h)
+SpscQueue<Telemetry, 4>  telemetryQueue;
+SpscQueue<CommandMsg, 8> commandQueue;
+SpscQueue<ReplyMsg, 4>   replyQueue;
+SpscQueue<AlertMsg, 8>   alertQueue;
+SpscQueue<Telemetry, 2>  webTelemetryQueue;
+SpscQueue<CommandMsg, 4> webCommandQueue;
+SpscQueue<ReplyMsg, 4>   webReplyQueue;
+SpscQueue<Telemetry, 4>  mqttTelemetryQueue;
+SpscQueue<CommandMsg, 4> mqttCommandQueue;
+SpscQueue<ReplyMsg, 4>   mqttReplyQueue;
+#if USE_TELEGRAM
+Dashboard dashboard;   // served by the web task once WiFi is up
+MqttReporter mqttReporter;   // batches to the broker, spools to flash offline
+#endif
+std::atomic<bool> otaRequested{false};
+std::atomic<bool> netTaskRunning{false};
+std::atomic<bool> safeStateRequested{false};
+std::atomic<bool> safeStateReached{false};
+
+// Control task runs the scheduler on the app core, away from WiFi
+#define CONTROL_CORE      1
+#define CONTROL_PRIORITY  3
+#define CONTROL_STACK     8192
+
+// Log drain: lowest priority on the network core, never competes with control
+#define LOG_CORE          0
+#define LOG_PRIORITY      1
+#define LOG_STACK         3072
+
+// === Climate sensors ===
+// Each room reads its own AHT20s. A sensor sits directly on a bus or
+// behind a TCA9548A channel, e.g. Aht20 vegAht(Wire, 0).
+#define I2C2_SDA  16
+#define I2C2_SCL  17
+
+Aht20 vegAht(Wire);
+Aht20 flowerAht(Wire1);
+Aht20 *climateSensors[] = { &vegAht, &flowerAht };
+
+// === Task periods (ms) ===
+#define SENSOR_PERIOD_MS     100   // AHT20 state machines, never block
+#define CLIMATE_PERIOD_MS   2000
+#define ADC_PERIOD_MS        100   // soil filter sample rate
+#define SOIL_PERIOD_MS      1000
+#define FLOOD_PERIOD_MS      100   // pump-off latency
+#define LIGHT_PERIOD_MS     1000   // clock watch; the wheel switches the lights
+#define STATUS_PERIOD_MS    5000
+#define CONSOLE_PERIOD_MS     20
+#define TELEMETRY_PERIOD_MS 1000
+#define CONFIG_PERIOD_MS    1000   // coalesced NVS saves
 
 void safeStartup() {
-  int allPins[] = {5,18,19,21,22,23,25,26,27,14};
-  for (int i = 0; i < 10; i++) {
-    pinMode(allPins[i], OUTPUT);
-    digitalWrite(allPins[i], LOW);
+  for (const RoomDef &d : ROOM_TABLE)
+    for (int8_t pin : d.relayPins) {
+      if (pin == NO_PIN) continue;
+      pinMode(pin, OUTPUT);
+      digitalWrite(pin, LOW);
+    }
+}
+
+// ------------------------------------------------------------------
+// Scheduled tasks
+// ------------------------------------------------------------------
+void taskSensor() {
+  for (Aht20 *s : climateSensors) s->poll();
+}
+
+// A missed reading holds the climate outputs; a failed or missing sensor
+// drops the room to schedule-only climate until it reads again
+void taskClimate() {
+  float t, h;
+  for (Room *r : rooms) {
+    bool ok = r->climate.read(t, h);
+    r->checkSensor(ok);
+    if (ok) r->controlEnvironment(t, h);
+    else if (r->sensorAlarm) r->scheduleOnlyClimate();
   }
 }
 
-void setup() {
-  Serial.begin(115200);
-  delay(1000);
-  safeStartup();
-  Serial.println("🌿 ESP32 Greenhouse Controller Booting...");
+void taskAdc() {
+  soilSensors.poll();
+}
 
-  Wire.begin();
-  if (!aht.begin()) {
-    Serial.println("⚠️ Could not find DHT20 sensor! Check wiring.");
-    while (1) delay(10);
+void taskSoil() {
+  for (Room *r : rooms) r->sampleSoil();
+}
+
+void taskFlood() {
+  for (Room *r : rooms) r->manageWatering();
+  irrigation.poll();
+}
+
+void taskLighting() {
+  for (Room *r : rooms) r->handleLighting();
+}
+
+void taskWheel() {
+  timerWheel.tick(millis64());
+}
+
+void taskStatus() {
+  float t, h;
+  for (Room *r : rooms) {
+    r->printStatus();
+    if (!r->climate.read(t, h))
+      logger.warn(r->logSrc, "⚠️ %s sensor %s", r->cfg.name.c_str(),
+                  r->sensorAlarm ? "missing, climate on schedule only" : "stale, holding climate outputs");
   }
+}
 
-  vegRoom.begin();
-  flowerRoom.begin();
+void taskConsole() {
+  handleSerial();
+}
 
-  loadConfig(vegRoom.cfg, "veg");
-  loadConfig(flowerRoom.cfg, "flower");
+void taskHistory() {
+  history.sample();
+}
 
-  showHelp();
+void taskConfig() {
+  configStore.poll();
+}
 
-#if USE_TELEGRAM
-  initWiFi();
-#endif
+void taskResume() {
+  resumeStore.poll();
 }
 
-void loop() {
-  sensors_event_t humidity, temp;
-  aht.getEvent(&humidity, &temp);
+void taskTelemetry() {
+  Telemetry t;
+  float temp, hum;
+  t.stamp     = millis();
+  t.roomCount = ROOM_COUNT;
+  for (uint8_t i = 0; i < ROOM_COUNT; i++) {
+    Room *r = rooms[i];
+    RoomTelemetry &rt = t.rooms[i];
+    rt.sensorOk = r->climate.read(temp, hum);
+    rt.temp     = r->lastTemp;
+    rt.hum      = r->lastHum;
+    rt.relays   = r->relays.states();
+    rt.floods   = 0;
+    for (uint8_t z = 0; z < r->zoneCount(); z++) {
+      rt.soil[z] = r->zoneSoil(z);
+      if (r->zoneWatering(z)) rt.floods |= 1 << z;
+    }
+  }
+  telemetryQueue.push(t);   // drops when the network side falls behind
+  webTelemetryQueue.push(t);
+  mqttTelemetryQueue.push(t);
+}
 
-  if (isnan(temp.temperature) || isnan(humidity.relative_humidity)) {
-    Serial.println("⚠️ Sensor read failed, skipping cycle");
-    delay(2000);
-    return;
+// Runs until an OTA reboot is pending, then parks every output and stops
+void controlTask(void *) {
+  power.bindWaker();
+  while (!safeStateRequested) {
+    power.idle(powerControl, scheduler.runDue());   // light-sleeps here in power save
+    if (power.takeSerialWake()) scheduler.trigger(consoleTask);
   }
+  configStore.flush();
+  resumeStore.checkpoint();   // before the floods are closed, so they rest after boot
+  for (Room *r : rooms) r->enterSafeState();
+  logger.warn(logControl, "🛑 Outputs parked for reboot");
+  safeStateReached = true;
+  vTaskSuspend(NULL);
+}
 
-  vegRoom.update(temp.temperature, humidity.relative_humidity);
-  flowerRoom.update(temp.temperature, humidity.relative_humidity);
+// Empties the log ring to the UART. Only console replies to serial input
+// (and the boot help) are written to Serial directly, by the task that
+// runs the command; everything else is logged through the ring.
+void logTask(void *) {
+  for (;;) {
+    logger.drain(Serial);
+    power.idle(powerLog, power.period(LOG_DRAIN_PERIOD_MS, POWER_LOG_DRAIN_MS));
+  }
+}
+
+// Boot order: outputs to a known state, rooms and lights under control,
+// then sensors and network come up in the background. Nothing here waits
+// on a device or the network.
+void setup() {
+  safeStartup();   // relays low before anything else runs
+  Serial.begin(115200);
+  power.add(powerControl, "control");
+  power.add(powerLog, "log");
+  xTaskCreatePinnedToCore(logTask, "log", LOG_STACK, nullptr, LOG_PRIORITY, nullptr, LOG_CORE);
+  logger.add(logControl);
+  logger.info(logControl, "🌿 ESP32 Greenhouse Controller Booting...");
+  power.begin(POWER_SAVE);   // relay pins must already be outputs
+
+  for (Room *r : rooms) r->begin();
+  for (Room *r : rooms) configStore.add(&r->cfg, r->name());
+  configStore.load();
+  resumeStore.restore();   // light phase, flood rest and min-run from before the reset
+  for (Room *r : rooms) r->handleLighting();   // lights on schedule from the first moment
+
+  // Each room reads its own AHT20s, detected by the sensor task; a room
+  // whose sensor never answers runs schedule-only climate
+  Wire.begin();
+  Wire1.begin(I2C2_SDA, I2C2_SCL);
+  for (Aht20 *s : climateSensors) s->begin();
+  vegRoom.climate.bind(&vegAht);
+  flowerRoom.climate.bind(&flowerAht);
+
+  soilSensors.begin(!power.enabled);   // after the rooms have registered their probes
+  soilCal.load();                      // per-probe curves and weights
+  history.begin();
 
-  handleSerial(temp.temperature, humidity.relative_humidity, vegRoom.getMotherSoil());
+  // Sensors first, then the stages that consume their readings
+  scheduler.add("sensor",    taskSensor,     SENSOR_PERIOD_MS);
+  scheduler.add("adc",       taskAdc,        ADC_PERIOD_MS);
+  scheduler.add("soil",      taskSoil,       SOIL_PERIOD_MS);
+  scheduler.add("climate",   taskClimate,    CLIMATE_PERIOD_MS);
+  scheduler.add("flood",     taskFlood,      FLOOD_PERIOD_MS);
+  scheduler.add("lighting",  taskLighting,   LIGHT_PERIOD_MS);
+  scheduler.add("wheel",     taskWheel,      WHEEL_TICK_MS);
+  consoleTask = scheduler.add("console", taskConsole, power.period(CONSOLE_PERIOD_MS, POWER_CONSOLE_MS));
+  scheduler.add("status",    taskStatus,     STATUS_PERIOD_MS, 500);
+  scheduler.add("telemetry", taskTelemetry,  TELEMETRY_PERIOD_MS);
+  scheduler.add("config",    taskConfig,     CONFIG_PERIOD_MS);
+  scheduler.add("history",   taskHistory,    HISTORY_SAMPLE_MS, 1000);
+  scheduler.add("resume",    taskResume,     RESUME_SAVE_MS);
 
+  xTaskCreatePinnedToCore(controlTask, "control", CONTROL_STACK, nullptr,
+                          CONTROL_PRIORITY, nullptr, CONTROL_CORE);
 #if USE_TELEGRAM
-  handleTelegram(temp.temperature, humidity.relative_humidity, vegRoom.getMotherSoil());
+  startNetworkTask();   // WiFi connects in the background
 #endif
+  logger.info(logControl, "✅ Control running %lu ms after power-on", millis());
+
+  showHelp();
+}
 
-  delay(5000);
+void loop() {
+  // Everything runs in the pinned control and network tasks
+  vTaskDelete(NULL);
 }
@@ -0,0 +1,212 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+// ---------- Hardware abstraction ----------
+// Board primitives beyond the Arduino API. The ESP32 versions talk to the
+// peripherals directly; the host build gets its own from sim/hal/HostHal.h.
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Arduino.h>
+#include "soc/gpio_reg.h"
+#include "esp_arduino_version.h"
+#include "esp_timer.h"
+#include <sys/time.h>
+#include <time.h>
+#include <lwip/sockets.h>
+#include <lwip/netdb.h>
+#include "esp_partition.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include "driver/uart.h"
+
+// Drive many outputs at once: each W1TS/W1TC write updates every pin in
+// its bank in the same bus cycle. Bit n = GPIO n (0-39).
+inline void gpioWriteMasks(uint64_t setPins, uint64_t clearPins) {
+  if ((uint32_t)setPins)           REG_WRITE(GPIO_OUT_W1TS_REG,  (uint32_t)setPins);
+  if ((uint32_t)clearPins)         REG_WRITE(GPIO_OUT_W1TC_REG,  (uint32_t)clearPins);
+  if ((uint32_t)(setPins >> 32))   REG_WRITE(GPIO_OUT1_W1TS_REG, (uint32_t)(setPins >> 32));
+  if ((uint32_t)(clearPins >> 32)) REG_WRITE(GPIO_OUT1_W1TC_REG, (uint32_t)(clearPins >> 32));
+}
+
+// ---------- One-shot timers and monotonic time ----------
+// esp_timer callbacks run in the high-priority esp_timer task, so they
+// fire on time even if the control loop is stalled.
+typedef esp_timer_handle_t OneShotHandle;
+const OneShotHandle ONESHOT_NONE = nullptr;
+
+inline uint64_t halMicros64() { return (uint64_t)esp_timer_get_time(); }
+
+// System time, which the RTC timer carries through software, OTA and
+// brownout resets (not power loss). Unlike halMicros64() it does not
+// restart at zero on boot.
+inline uint64_t halRtcMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return (uint64_t)tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+// Local wall time in ms since 1970-01-01 00:00 local, once SNTP (or a
+// reset that kept the RTC) has set the clock; false before that.
+#define WALL_VALID_AFTER  1700000000L   // any earlier time() is an unset clock
+
+inline bool halWallMs(uint64_t &localMs) {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  if (tv.tv_sec < WALL_VALID_AFTER) return false;
+  time_t t = tv.tv_sec;
+  struct tm tm;
+  localtime_r(&t, &tm);
+  int y = tm.tm_year + 1900;
+  int64_t days = 365LL * (y - 1970) + (y - 1969) / 4 - (y - 1901) / 100 + (y - 1601) / 400 + tm.tm_yday;
+  localMs = ((uint64_t)days * 86400 + tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec) * 1000 +
+            tv.tv_usec / 1000;
+  return true;
+}
+
+inline OneShotHandle oneShotCreate(void (*cb)(void *), void *arg, const char *name) {
+  esp_timer_create_args_t args = {};
+  args.callback = cb;
+  args.arg = arg;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = name;
+  esp_timer_handle_t h = nullptr;
+  return esp_timer_create(&args, &h) == ESP_OK ? h : ONESHOT_NONE;
+}
+
+inline bool oneShotStart(OneShotHandle h, uint64_t us) {
+  if (h == ONESHOT_NONE) return false;
+  esp_timer_stop(h);   // re-arm cleanly if still pending
+  return esp_timer_start_once(h, us) == ESP_OK;
+}
+
+inline void oneShotStop(OneShotHandle h) {
+  if (h != ONESHOT_NONE) esp_timer_stop(h);
+}
+
+// ---------- Cycle counter ----------
+// CCOUNT runs at the CPU clock and wraps every ~18 s at 240 MHz, far
+// longer than any stage we time.
+inline uint32_t halCycles()      { return ESP.getCycleCount(); }
+inline uint32_t halCyclesPerUs() { return ESP.getCpuFreqMHz(); }
+
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+// Continuous (DMA) conversion of ADC1 pins; each result is the average of
+// `oversample` conversions taken by the driver.
+inline size_t adcStreamPins = 0;
+
+inline bool adcStreamBegin(const uint8_t *pins, size_t n, uint32_t oversample, uint32_t hz) {
+  adcStreamPins = n;
+  return analogContinuous(pins, n, oversample, hz, nullptr) && analogContinuousStart();
+}
+
+// Newest averaged frame without waiting; returns pins filled, 0 if none.
+inline int adcStreamRead(uint8_t *pins, uint16_t *raw, int max) {
+  adc_continuous_data_t *frame = nullptr;
+  if (!analogContinuousRead(&frame, 0) || !frame) return 0;
+  int n = 0;
+  for (size_t i = 0; i < adcStreamPins && n < max; i++) {
+    pins[n] = frame[i].pin;
+    raw[n++] = frame[i].avg_read_raw;
+  }
+  return n;
+}
+#else
+// Core 2.x has no continuous ADC API; callers fall back to analogRead.
+inline bool adcStreamBegin(const uint8_t *, size_t, uint32_t, uint32_t) { return false; }
+inline int adcStreamRead(uint8_t *, uint16_t *, int) { return 0; }
+#endif
+
+// ---------- Sockets ----------
+// lwIP's BSD socket API; the host build uses the system's. Sends never
+// block, so one slow client cannot stall the task serving the others.
+inline bool halSockNonBlocking(int fd) { return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) == 0; }
+inline int  halSockSend(int fd, const void *buf, size_t n) { return send(fd, buf, n, MSG_DONTWAIT); }
+inline void halSockClose(int fd) { closesocket(fd); }
+
+// IPv4 address of a broker name or dotted quad; blocks on DNS
+inline bool halResolve(const char *host, uint16_t port, struct sockaddr_in &out) {
+  struct addrinfo hints = {}, *res = nullptr;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  char service[6];
+  snprintf(service, sizeof(service), "%u", port);
+  if (getaddrinfo(host, service, &hints, &res) || !res) return false;
+  memcpy(&out, res->ai_addr, sizeof(out));
+  freeaddrinfo(res);
+  return true;
+}
+
+// ---------- Power ----------
+// Automatic light-sleep: the idle task sleeps whenever every task is
+// blocked, a timer deadline or UART RX wakes it, and the CPU clock drops
+// to minMhz when nothing holds it up. Needs a core built with
+// CONFIG_PM_ENABLE and tickless idle; false if it is not.
+inline bool halPowerSave(uint16_t maxMhz, uint16_t minMhz) {
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  esp_pm_config_t cfg = {};
+#else
+  esp_pm_config_esp32_t cfg = {};
+#endif
+  cfg.max_freq_mhz = maxMhz;
+  cfg.min_freq_mhz = minMhz;
+  cfg.light_sleep_enable = true;
+  return esp_pm_configure(&cfg) == ESP_OK;
+}
+
+inline uint16_t halCpuMhz() { return ESP.getCpuFreqMHz(); }
+
+// Keep a pin's awake configuration (and so its output level) through
+// light-sleep instead of switching to the sleep pad settings
+inline void halSleepKeepPin(int pin) { gpio_sleep_sel_dis((gpio_num_t)pin); }
+
+// Wake from light-sleep after `edges` RX edges on the console UART; the
+// bytes that woke it are lost. cb runs in the UART event task.
+inline bool halSerialWake(uint8_t edges, void (*cb)()) {
+#if defined(ESP_ARDUINO_VERSION_VAL) && ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(2, 0, 5)
+  Serial.onReceive(cb);
+#else
+  (void)cb;
+#endif
+  return uart_set_wakeup_threshold(UART_NUM_0, edges) == ESP_OK && esp_sleep_enable_uart_wakeup(0) == ESP_OK;
+}
+
+// Block the calling task for up to ms or until halWakeTask() on it
+typedef TaskHandle_t HalTask;
+inline HalTask halCurrentTask() { return xTaskGetCurrentTaskHandle(); }
+inline void halWaitWake(uint32_t ms) { ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms)); }
+inline void halWakeTask(HalTask t) { if (t) xTaskNotifyGive(t); }
+
+// ---------- Spool flash ----------
+// Raw NOR flash for the MQTT spool (Spool.h): the data partition the
+// default partition tables reserve for SPIFFS, which this sketch does not
+// mount. Erase works in whole sectors; a write can only clear bits.
+#define HAL_SPOOL_SECTOR  4096
+
+inline const esp_partition_t *halSpoolPartition() {
+  static const esp_partition_t *p =
+    esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, nullptr);
+  return p;
+}
+
+inline uint32_t halSpoolSize() { return halSpoolPartition() ? halSpoolPartition()->size : 0; }
+inline bool halSpoolErase(uint32_t off) {
+  return esp_partition_erase_range(halSpoolPartition(), off, HAL_SPOOL_SECTOR) == ESP_OK;
+}
+inline bool halSpoolWrite(uint32_t off, const void *p, size_t n) {
+  return esp_partition_write(halSpoolPartition(), off, p, n) == ESP_OK;
+}
+inline bool halSpoolRead(uint32_t off, void *p, size_t n) {
+  return esp_partition_read(halSpoolPartition(), off, p, n) == ESP_OK;
+}
+
+#else
+#include <HostHal.h>
+#endif
+
+// Monotonic ms since boot that never wraps, for schedules and deadlines
+inline uint64_t millis64() { return halMicros64() / 1000; }
+
+#endif
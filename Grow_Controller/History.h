@@ -0,0 +1,378 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "Rooms.h"
+
+// === History retention ===
+#define HISTORY_SAMPLE_MS      10000   // raw sample period
+#define HISTORY_RAW_BYTES       8192   // delta/varint sample log, ~1 h at 16 channels
+#define HISTORY_BLOCK_BYTES      512   // the raw log drops its oldest block when full
+#define HISTORY_MINUTE_BYTES   12288   // minute rollups, ~2 h at 16 channels
+#define HISTORY_HOUR_BYTES     16384   // hour rollups, ~7 days at 16 channels
+#define HISTORY_MAX_CHANNELS      32
+#define HISTORY_ROWS              12   // lines in one history reply
+#define HISTORY_NONE       INT16_MIN   // no valid reading
+
+// ---------- Time-series store ----------
+// Every HISTORY_SAMPLE_MS each channel (temperature, humidity, zone soil,
+// relay state) is sampled as a scaled int16. Samples go three places:
+//   - a raw log of frames, each a varint time step plus one zig-zag
+//     varint delta per channel, in fixed blocks that start with absolute
+//     values so the oldest block can be dropped without re-encoding;
+//   - per-minute and per-hour min/max/avg rings, indexed by period so a
+//     range lookup is plain arithmetic.
+// All memory is static; retention shrinks as channels are added. Relay
+// channels sample as 0 or 100, so their averages read as % on-time.
+
+struct Rollup {
+  int16_t min, max, avg;
+};
+
+// Running min/max/sum for the period being filled
+struct RollupAccum {
+  int32_t  sum = 0;
+  int16_t  min = INT16_MAX, max = INT16_MIN;
+  uint16_t n = 0;
+
+  void add(int16_t v) {
+    if (v == HISTORY_NONE) return;
+    sum += v; n++;
+    if (v < min) min = v;
+    if (v > max) max = v;
+  }
+
+  Rollup take() {
+    Rollup r = { HISTORY_NONE, HISTORY_NONE, HISTORY_NONE };
+    if (n) r = { min, max, (int16_t)(sum / n) };
+    *this = RollupAccum();
+    return r;
+  }
+};
+
+// Fixed ring of rollup rows, one row (width channels) per period.
+class RollupRing {
+public:
+  void begin(Rollup *pool, size_t poolLen, uint8_t channels) {
+    slots = pool;
+    width = channels ? channels : 1;
+    capacity = poolLen / width;
+    count = 0;
+  }
+
+  void push(uint32_t period, const Rollup *row) {
+    if (!capacity) return;
+    // periods with no samples (e.g. a stalled task) read back as empty
+    const Rollup empty = { HISTORY_NONE, HISTORY_NONE, HISTORY_NONE };
+    while (count && newest + 1 < period) {
+      advance(newest + 1);
+      for (uint8_t c = 0; c < width; c++) slots[head * width + c] = empty;
+    }
+    advance(period);
+    memcpy(&slots[head * width], row, width * sizeof(Rollup));
+  }
+
+  // Row for a period, or nullptr once it has been overwritten
+  const Rollup *row(uint32_t period) const {
+    if (!count || period > newest || newest - period >= count) return nullptr;
+    uint16_t i = (head + capacity - (newest - period)) % capacity;
+    return &slots[i * width];
+  }
+
+  uint16_t size() const { return count; }
+
+private:
+  Rollup  *slots = nullptr;
+  uint16_t capacity = 0, head = 0, count = 0;
+  uint8_t  width = 1;
+  uint32_t newest = 0;
+
+  void advance(uint32_t period) {
+    head = count ? (head + 1) % capacity : 0;
+    if (count < capacity) count++;
+    newest = period;
+  }
+};
+
+// Delta/varint log of raw frames in HISTORY_BLOCK_BYTES blocks.
+class SampleLog {
+public:
+  static const uint8_t BLOCKS = HISTORY_RAW_BYTES / HISTORY_BLOCK_BYTES;
+
+  void begin(uint8_t channels) { width = channels; }
+
+  void append(uint32_t t, const int16_t *v) {
+    uint8_t frame[3 + HISTORY_MAX_CHANNELS * 3];
+    size_t len = encode(frame, t, v, blocks[cur].used == 0);
+    if (blocks[cur].used + len > HISTORY_BLOCK_BYTES) {
+      cur = (cur + 1) % BLOCKS;
+      if (filled < BLOCKS) filled++;
+      blocks[cur].used = 0;
+      len = encode(frame, t, v, true);   // every block opens with absolute values
+    }
+    if (blocks[cur].used == 0) {
+      if (!filled) filled = 1;
+      blocks[cur].t0 = t;
+    }
+    memcpy(&buf[cur * HISTORY_BLOCK_BYTES + blocks[cur].used], frame, len);
+    blocks[cur].used += len;
+    memcpy(last, v, width * sizeof(int16_t));
+    lastT = t;
+  }
+
+  // Start time of the oldest frame still held
+  bool oldest(uint32_t &t) const {
+    if (!filled) return false;
+    t = blocks[first()].t0;
+    return true;
+  }
+
+  // Call fn(t, value) for channel ch in every frame with from <= t <= to.
+  template <typename Fn>
+  void forEach(uint8_t ch, uint32_t from, uint32_t to, Fn fn) const {
+    for (uint8_t k = 0; k < filled; k++) {
+      uint8_t b = (first() + k) % BLOCKS;
+      // skip blocks that end before the range
+      if (k + 1 < filled && blocks[(b + 1) % BLOCKS].t0 <= from) continue;
+      if (blocks[b].t0 > to) break;
+      const uint8_t *p = &buf[b * HISTORY_BLOCK_BYTES];
+      const uint8_t *end = p + blocks[b].used;
+      uint32_t t = blocks[b].t0;
+      int16_t vals[HISTORY_MAX_CHANNELS];
+      bool key = true;
+      while (p < end) {
+        if (!key) t += readVarint(p);
+        for (uint8_t c = 0; c < width; c++) {
+          int32_t d = unzigzag(readVarint(p));
+          vals[c] = key ? (int16_t)d : (int16_t)(vals[c] + d);
+        }
+        key = false;
+        if (t > to) return;
+        if (t >= from) fn(t, vals[ch]);
+      }
+    }
+  }
+
+private:
+  uint8_t  buf[HISTORY_RAW_BYTES];
+  struct { uint32_t t0; uint16_t used; } blocks[BLOCKS] = {};
+  uint8_t  cur = 0, filled = 0, width = 0;
+  int16_t  last[HISTORY_MAX_CHANNELS];
+  uint32_t lastT = 0;
+
+  uint8_t first() const { return filled < BLOCKS ? 0 : (cur + 1) % BLOCKS; }
+
+  static uint32_t zigzag(int32_t v)   { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+  static int32_t  unzigzag(uint32_t u) { return (int32_t)(u >> 1) ^ -(int32_t)(u & 1); }
+
+  static void writeVarint(uint8_t *&p, uint32_t u) {
+    while (u >= 0x80) { *p++ = (uint8_t)(u | 0x80); u >>= 7; }
+    *p++ = (uint8_t)u;
+  }
+
+  static uint32_t readVarint(const uint8_t *&p) {
+    uint32_t u = 0;
+    for (uint8_t shift = 0; ; shift += 7) {
+      uint8_t b = *p++;
+      u |= (uint32_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) return u;
+    }
+  }
+
+  // Key frames hold absolute values and no time step
+  size_t encode(uint8_t *out, uint32_t t, const int16_t *v, bool key) const {
+    uint8_t *p = out;
+    if (!key) writeVarint(p, t - lastT);
+    for (uint8_t c = 0; c < width; c++)
+      writeVarint(p, zigzag(key ? v[c] : (int32_t)v[c] - last[c]));
+    return p - out;
+  }
+};
+
+// ---------- Channels ----------
+enum HistoryKind : uint8_t { HIST_TEMP, HIST_HUM, HIST_SOIL, HIST_RELAY, HIST_VPD };
+
+struct HistoryChannel {
+  const char *owner;    // room or zone name
+  const char *metric;   // temp, hum, vpd, soil, heater, exhaust, light, flood, ...
+  Room       *room;
+  HistoryKind kind;
+  uint8_t     index;    // zone or relay channel
+};
+
+class History {
+public:
+  // Channels for every room: climate, each zone's soil and flood relay,
+  // and the climate and light relays the room has.
+  void begin() {
+    for (Room *r : rooms) {
+      add(r->name(), "temp", r, HIST_TEMP, 0);
+      add(r->name(), "hum",  r, HIST_HUM, 0);
+      add(r->name(), "vpd",  r, HIST_VPD, 0);
+      addRelay(r, "heater",  RELAY_HEATER);
+      addRelay(r, "exhaust", RELAY_EXHAUST);
+      addRelay(r, "light",   RELAY_LIGHT);
+      addRelay(r, "intake",  RELAY_INTAKE);
+      addRelay(r, "humidifier", RELAY_HUMIDIFIER);
+      addRelay(r, "dehumidifier", RELAY_DEHUMIDIFIER);
+      for (uint8_t z = 0; z < r->zoneCount(); z++) {
+        add(r->def.zones[z].name, "soil",  r, HIST_SOIL, z);
+        add(r->def.zones[z].name, "flood", r, HIST_RELAY, r->def.zones[z].relay);
+      }
+    }
+    raw.begin(count);
+    minutes.begin(minutePool, sizeof(minutePool) / sizeof(Rollup), count);
+    hours.begin(hourPool, sizeof(hourPool) / sizeof(Rollup), count);
+  }
+
+  // Scheduler task, every HISTORY_SAMPLE_MS
+  void sample() {
+    uint32_t t = nowSec();
+    int16_t v[HISTORY_MAX_CHANNELS];
+    for (uint8_t c = 0; c < count; c++) v[c] = read(channels[c]);
+
+    if (started) {
+      if (t / 60 != minute)  flush(minuteAcc, minutes, minute);
+      if (t / 3600 != hour)  flush(hourAcc, hours, hour);
+    }
+    started = true;
+    minute = t / 60;
+    hour = t / 3600;
+    for (uint8_t c = 0; c < count; c++) { minuteAcc[c].add(v[c]); hourAcc[c].add(v[c]); }
+    raw.append(t, v);
+  }
+
+  int find(const char *owner, const char *metric) const {
+    for (uint8_t c = 0; c < count; c++)
+      if (!strcasecmp(channels[c].owner, owner) && !strcasecmp(channels[c].metric, metric)) return c;
+    return -1;
+  }
+
+  uint8_t size() const { return count; }
+  const HistoryChannel &channel(uint8_t c) const { return channels[c]; }
+
+  // Seconds of history each tier holds right now
+  uint32_t rawSpan() const {
+    uint32_t t0;
+    return raw.oldest(t0) ? nowSec() - t0 : 0;
+  }
+  uint32_t minuteSpan() const { return minutes.size() * 60UL; }
+  uint32_t hourSpan() const   { return hours.size() * 3600UL; }
+
+  // Summarise channel c over the last spanSec seconds into
+  // rows[HISTORY_ROWS] equal buckets, picking the finest tier that reaches
+  // back far enough. Returns the tier used ("raw", "minute", "hour").
+  const char *query(uint8_t c, uint32_t spanSec, RollupAccum *rows, uint32_t &bucketSec) const {
+    uint32_t now = nowSec();
+    uint32_t from = spanSec < now ? now - spanSec : 0;
+    bucketSec = (spanSec + HISTORY_ROWS - 1) / HISTORY_ROWS;
+    if (bucketSec == 0) bucketSec = 1;
+
+    auto bucket = [&](uint32_t t) -> RollupAccum * {
+      if (t < from) return nullptr;
+      uint32_t i = (t - from) / bucketSec;
+      return i < HISTORY_ROWS ? &rows[i] : nullptr;
+    };
+
+    if (spanSec <= rawSpan() || spanSec <= 60) {
+      raw.forEach(c, from, now, [&](uint32_t t, int16_t v) {
+        if (RollupAccum *a = bucket(t)) a->add(v);
+      });
+      return "raw";
+    }
+    bool useMinutes = spanSec <= minuteSpan() + 60;
+    const RollupRing &ring = useMinutes ? minutes : hours;
+    uint32_t period = useMinutes ? 60 : 3600;
+    for (uint32_t p = from / period; p < now / period; p++) {
+      const Rollup *row = ring.row(p);
+      if (row) fold(bucket(max(p * period, from)), row[c]);
+    }
+    // the period still being filled has not reached the ring yet
+    RollupAccum live = (useMinutes ? minuteAcc : hourAcc)[c];
+    fold(bucket(max(now / period * period, from)), live.take());
+    return useMinutes ? "minute" : "hour";
+  }
+
+  // Scale a stored value back to display units
+  static float toUnits(const HistoryChannel &ch, int16_t v) {
+    if (ch.kind == HIST_VPD) return v / 100.0f;
+    return (ch.kind == HIST_TEMP || ch.kind == HIST_HUM || ch.kind == HIST_SOIL) ? v / 10.0f : v;
+  }
+
+  // Decimals worth showing for a channel
+  static int precision(const HistoryChannel &ch) {
+    return ch.kind == HIST_VPD ? 2 : (ch.kind == HIST_TEMP || ch.kind == HIST_HUM || ch.kind == HIST_SOIL) ? 1 : 0;
+  }
+
+  static const char *unit(const HistoryChannel &ch) {
+    switch (ch.kind) {
+      case HIST_TEMP:  return "°C";
+      case HIST_HUM:
+      case HIST_SOIL:  return "%";
+      case HIST_VPD:   return "kPa";
+      case HIST_RELAY: return "% on";
+      default:         return "";
+    }
+  }
+
+private:
+  HistoryChannel channels[HISTORY_MAX_CHANNELS];
+  uint8_t        count = 0;
+
+  SampleLog   raw;
+  Rollup      minutePool[HISTORY_MINUTE_BYTES / sizeof(Rollup)];
+  Rollup      hourPool[HISTORY_HOUR_BYTES / sizeof(Rollup)];
+  RollupRing  minutes, hours;
+  RollupAccum minuteAcc[HISTORY_MAX_CHANNELS], hourAcc[HISTORY_MAX_CHANNELS];
+  uint32_t    minute = 0, hour = 0;
+  bool        started = false;
+
+  // Uptime in s from the 64-bit clock: millis() wraps after 49.7 days,
+  // shorter than a flower cycle, and every time key must keep rising
+  static uint32_t nowSec() { return (uint32_t)(millis64() / 1000); }
+
+  void add(const char *owner, const char *metric, Room *r, HistoryKind kind, uint8_t index) {
+    if (count < HISTORY_MAX_CHANNELS) channels[count++] = { owner, metric, r, kind, index };
+  }
+
+  // Room relays that are wired; zone relays are recorded as the zone's flood
+  void addRelay(Room *r, const char *metric, uint8_t ch) {
+    if (r->relays.pin(ch) >= 0 && !r->zoneRelay(ch)) add(r->name(), metric, r, HIST_RELAY, ch);
+  }
+
+  static int16_t scaled(float v, float scale) {
+    if (isnan(v)) return HISTORY_NONE;
+    long r = lroundf(v * scale);
+    if (r <= HISTORY_NONE) r = HISTORY_NONE + 1;   // keep clear of the no-reading marker
+    if (r > INT16_MAX) r = INT16_MAX;
+    return (int16_t)r;
+  }
+
+  static int16_t read(const HistoryChannel &ch) {
+    switch (ch.kind) {
+      case HIST_TEMP:  return scaled(ch.room->lastTemp, 10);
+      case HIST_HUM:   return scaled(ch.room->lastHum, 10);
+      case HIST_VPD:   return scaled(ch.room->lastVpd, 100);
+      case HIST_SOIL:  return scaled(ch.room->zoneSoil(ch.index), 10);
+      case HIST_RELAY: return ch.room->relays.get(ch.index) ? 100 : 0;
+    }
+    return HISTORY_NONE;
+  }
+
+  // Merge one period's rollup into a bucket as a single sample, keeping its extremes
+  static void fold(RollupAccum *a, const Rollup &r) {
+    if (!a || r.avg == HISTORY_NONE) return;
+    a->add(r.avg);
+    if (r.min < a->min) a->min = r.min;
+    if (r.max > a->max) a->max = r.max;
+  }
+
+  void flush(RollupAccum *acc, RollupRing &ring, uint32_t period) {
+    Rollup row[HISTORY_MAX_CHANNELS];
+    for (uint8_t c = 0; c < count; c++) row[c] = acc[c].take();
+    ring.push(period, row);
+  }
+};
+
+extern History history;
+
+#endif
@@ -0,0 +1,518 @@
+#ifndef HTTPSERVER_H
+#define HTTPSERVER_H
+
+#include <string.h>
+#include <stdarg.h>
+#include "Hal.h"
+
+#define HTTP_MAX_CLIENTS  4        // sockets served at once, dashboards included
+#define HTTP_REQ_MAX      1024     // request line, headers and body
+#define HTTP_IDLE_MS      10000    // drop a request that has not fully arrived by then
+#define WS_STALL_MS       30000    // drop a subscriber that has taken nothing for this long
+#define HTTP_OUT_CHUNKS   4        // responses and frames queued per client
+#define FRAME_POOL        8        // shared buffers for responses and pushes
+#define FRAME_HEADROOM    192      // room for the HTTP or WebSocket header in front
+#define FRAME_MAX         1536     // body bytes per buffer
+
+// ---------- Shared frames ----------
+// A frame is built once and queued to any number of clients by
+// reference. Each client holds one count until its copy is on the wire;
+// the last release hands the buffer back to the pool. The header goes
+// into the headroom in front of the finished body, so nothing is copied
+// per client. Only the web task touches frames, so plain counts do.
+struct SharedFrame {
+  uint8_t  refs = 0;
+  bool     overflow = false;           // a write did not fit, the body is incomplete
+  uint16_t begin = 0, end = 0;         // data[begin, end) goes on the wire
+  char     data[FRAME_HEADROOM + FRAME_MAX];
+
+  size_t      size() const { return end - begin; }
+  const char *body() const { return data + begin; }
+
+  void appendf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+    size_t room = sizeof(data) - end;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(data + end, room, fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= room) overflow = true;
+    else end += n;
+  }
+
+  void append(const char *s, size_t n) {
+    if (n > sizeof(data) - end) { overflow = true; return; }
+    memcpy(data + end, s, n);
+    end += n;
+  }
+
+  bool prepend(const char *s, size_t n) {
+    if (n > begin) return false;
+    begin -= n;
+    memcpy(data + begin, s, n);
+    return true;
+  }
+};
+
+class FramePool {
+public:
+  uint32_t exhausted = 0;   // acquire() found every buffer in flight
+
+  SharedFrame *acquire() {
+    for (SharedFrame &f : frames) {
+      if (f.refs) continue;
+      f.refs = 1;
+      f.overflow = false;
+      f.begin = f.end = FRAME_HEADROOM;
+      return &f;
+    }
+    exhausted++;
+    return nullptr;
+  }
+
+  static void retain(SharedFrame *f)  { f->refs++; }
+  static void release(SharedFrame *f) { if (f) f->refs--; }
+
+private:
+  SharedFrame frames[FRAME_POOL];
+};
+
+// ---------- WebSocket handshake ----------
+// Sec-WebSocket-Accept is base64(SHA-1(key + GUID)). SHA-1 lives here
+// rather than coming from mbedtls so the host build needs no TLS library.
+namespace ws_detail {
+
+inline uint32_t rol(uint32_t v, int n) { return v << n | v >> (32 - n); }
+
+inline void sha1(const uint8_t *msg, size_t len, uint8_t out[20]) {
+  uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+  uint64_t bits = (uint64_t)len * 8;
+  size_t total = ((len + 8) / 64 + 1) * 64;   // message, 0x80, zeros, 64-bit length
+  for (size_t off = 0; off < total; off += 64) {
+    uint32_t w[80];
+    for (int i = 0; i < 64; i++) {
+      size_t p = off + i;
+      uint8_t b = p < len ? msg[p] : p == len ? 0x80 : p >= total - 8 ? (uint8_t)(bits >> (8 * (total - 1 - p))) : 0;
+      if (i % 4 == 0) w[i / 4] = 0;
+      w[i / 4] |= (uint32_t)b << (24 - 8 * (i % 4));
+    }
+    for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+      uint32_t f, k;
+      if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+      else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+      else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+      else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+      uint32_t t = rol(a, 5) + f + e + k + w[i];
+      e = d; d = c; c = rol(b, 30); b = a; a = t;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+  }
+  for (int i = 0; i < 20; i++) out[i] = (uint8_t)(h[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+inline size_t base64(const uint8_t *in, size_t n, char *out) {
+  static const char T[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t o = 0;
+  for (size_t i = 0; i < n; i += 3) {
+    uint32_t v = (uint32_t)in[i] << 16 | (i + 1 < n ? in[i + 1] << 8 : 0) | (i + 2 < n ? in[i + 2] : 0);
+    out[o++] = T[v >> 18 & 63];
+    out[o++] = T[v >> 12 & 63];
+    out[o++] = i + 1 < n ? T[v >> 6 & 63] : '=';
+    out[o++] = i + 2 < n ? T[v & 63] : '=';
+  }
+  out[o] = '\0';
+  return o;
+}
+
+// Value of header `name` inside [p, end), not terminated; nullptr if absent
+inline const char *header(const char *p, const char *end, const char *name, size_t &len) {
+  size_t nl = strlen(name);
+  while (p < end) {
+    const char *eol = (const char *)memchr(p, '\n', end - p);
+    if (!eol) eol = end;
+    if ((size_t)(eol - p) > nl && p[nl] == ':' && !strncasecmp(p, name, nl)) {
+      const char *v = p + nl + 1;
+      while (v < eol && *v == ' ') v++;
+      const char *e = eol;
+      while (e > v && (e[-1] == '\r' || e[-1] == ' ')) e--;
+      len = e - v;
+      return v;
+    }
+    p = eol + 1;
+  }
+  return nullptr;
+}
+
+}  // namespace ws_detail
+
+// ---------- Non-blocking HTTP/1.1 + WebSocket server ----------
+// One task drives everything through poll(), which waits in select() for
+// at most waitMs. Requests are read into a fixed per-client buffer and
+// handed to the handler complete; the handler answers at once or later
+// through respond() with the request's id, so it may wait on another
+// task. Every HTTP response closes the connection. Clients that open
+// wsPath become WebSocket subscribers and get every broadcast(); one
+// that cannot keep up skips to the newest frame instead of queueing.
+struct HttpRequest {
+  uint16_t    id;       // for respond(); stale once the client has gone
+  const char *method;
+  const char *path;
+  const char *body;     // NUL-terminated
+  size_t      bodyLen;
+};
+
+typedef void (*HttpHandler)(void *ctx, const HttpRequest &req);
+
+class HttpServer {
+public:
+  FramePool pool;
+  uint32_t  requests = 0, rejected = 0;       // rejected: no free client slot
+  uint32_t  wsFrames = 0, wsSkipped = 0;      // pushes queued, and replaced by a newer one
+
+  bool begin(uint16_t port, HttpHandler fn, void *ctx, const char *wsPath) {
+    handler = fn;
+    handlerCtx = ctx;
+    wsRoute = wsPath;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) || listen(fd, HTTP_MAX_CLIENTS) ||
+        !halSockNonBlocking(fd)) {
+      halSockClose(fd);
+      return false;
+    }
+    listenFd = fd;
+    return true;
+  }
+
+  bool listening() const { return listenFd >= 0; }
+
+  uint8_t wsClients() const {
+    uint8_t n = 0;
+    for (const Client &c : clients) n += c.fd >= 0 && c.ws;
+    return n;
+  }
+
+  void poll(uint32_t waitMs) {
+    if (listenFd < 0) return;
+    fd_set rd, wr;
+    FD_ZERO(&rd);
+    FD_ZERO(&wr);
+    FD_SET(listenFd, &rd);
+    int maxFd = listenFd;
+    for (Client &c : clients) {
+      if (c.fd < 0) continue;
+      if (!c.waiting && !c.closing) FD_SET(c.fd, &rd);
+      if (c.outCount) FD_SET(c.fd, &wr);
+      if (c.fd > maxFd) maxFd = c.fd;
+    }
+    struct timeval tv;
+    tv.tv_sec = waitMs / 1000;
+    tv.tv_usec = (waitMs % 1000) * 1000;
+    if (select(maxFd + 1, &rd, &wr, nullptr, &tv) < 0) return;
+
+    if (FD_ISSET(listenFd, &rd)) acceptClients();
+    uint64_t now = millis64();
+    for (Client &c : clients) {
+      if (c.fd < 0) continue;
+      if (FD_ISSET(c.fd, &rd)) receive(c);
+      if (c.fd >= 0 && c.outCount) flush(c);
+      if (c.fd < 0) continue;
+      if (c.ws ? c.outCount && now - c.lastMs > WS_STALL_MS : !c.waiting && now - c.lastMs > HTTP_IDLE_MS) drop(c);
+    }
+  }
+
+  // Answer a request with a body built in a pool frame; takes the caller's reference
+  void respond(uint16_t id, int status, const char *type, SharedFrame *body) {
+    Client *c = lookup(id);
+    if (!c || !body || body->overflow) {
+      FramePool::release(body);
+      if (c) respondText(id, 500, "response too large");
+      return;
+    }
+    char head[FRAME_HEADROOM];
+    int n = formatHead(head, status, type, body->size());
+    if (!body->prepend(head, n)) { FramePool::release(body); drop(*c); return; }
+    queue(*c, body->body(), body->size(), body, false);
+    answered(*c);
+  }
+
+  // Answer with constant data (e.g. a page in flash), sent in place
+  void respondStatic(uint16_t id, int status, const char *type, const char *data, size_t len) {
+    Client *c = lookup(id);
+    if (!c) return;
+    SharedFrame *head = pool.acquire();
+    if (!head) { drop(*c); return; }
+    char buf[FRAME_HEADROOM];
+    head->append(buf, formatHead(buf, status, type, len));
+    queue(*c, head->body(), head->size(), head, false);
+    queue(*c, data, len, nullptr, false);
+    answered(*c);
+  }
+
+  void respondText(uint16_t id, int status, const char *text) {
+    Client *c = lookup(id);
+    if (!c) return;
+    SharedFrame *f = pool.acquire();
+    if (!f) { drop(*c); return; }
+    f->appendf("%d %s: %s\n", status, statusText(status), text);
+    respond(id, status, "text/plain; charset=utf-8", f);
+  }
+
+  // Push a text message to every WebSocket client; takes the caller's
+  // reference and keeps it, so a client that connects later starts with
+  // the newest frame.
+  void broadcast(SharedFrame *f) {
+    if (!f) return;
+    if (f->overflow) { FramePool::release(f); return; }
+    char hdr[4] = { (char)0x81 };   // FIN + text
+    size_t hl = 2, n = f->size();
+    if (n < 126) hdr[1] = (char)n;
+    else { hdr[1] = 126; hdr[2] = (char)(n >> 8); hdr[3] = (char)n; hl = 4; }
+    if (!f->prepend(hdr, hl)) { FramePool::release(f); return; }
+    FramePool::release(latest);
+    latest = f;
+    for (Client &c : clients)
+      if (c.fd >= 0 && c.ws && !c.closing) push(c, f);
+  }
+
+private:
+  struct Chunk {
+    const char  *data;
+    uint16_t     len;
+    SharedFrame *frame;   // released once sent; nullptr for constant data
+    bool         push;    // a broadcast, may be replaced by a newer one
+  };
+
+  struct Client {
+    int      fd = -1;
+    uint8_t  gen = 0;                 // bumped per connection, part of the request id
+    bool     ws = false;
+    bool     waiting = false;         // request with the handler, not answered yet
+    bool     closing = false;         // close once the output queue is empty
+    uint16_t inLen = 0;
+    char     in[HTTP_REQ_MAX + 1];
+    Chunk    out[HTTP_OUT_CHUNKS];
+    uint8_t  outHead = 0, outCount = 0;
+    uint16_t sent = 0;                // bytes of out[outHead] already on the wire
+    uint64_t lastMs = 0;
+  };
+
+  int          listenFd = -1;
+  HttpHandler  handler = nullptr;
+  void        *handlerCtx = nullptr;
+  const char  *wsRoute = nullptr;
+  SharedFrame *latest = nullptr;
+  Client       clients[HTTP_MAX_CLIENTS];
+
+  static const char *statusText(int status) {
+    switch (status) {
+      case 101: return "Switching Protocols";
+      case 200: return "OK";
+      case 400: return "Bad Request";
+      case 404: return "Not Found";
+      case 405: return "Method Not Allowed";
+      case 413: return "Payload Too Large";
+      case 503: return "Service Unavailable";
+      case 504: return "Gateway Timeout";
+      default:  return "Internal Server Error";
+    }
+  }
+
+  static int formatHead(char *buf, int status, const char *type, size_t len) {
+    int n = snprintf(buf, FRAME_HEADROOM,
+                     "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %u\r\n"
+                     "Cache-Control: no-store\r\nConnection: close\r\n\r\n",
+                     status, statusText(status), type, (unsigned)len);
+    return n < FRAME_HEADROOM ? n : FRAME_HEADROOM - 1;
+  }
+
+  Client *lookup(uint16_t id) {
+    uint8_t i = id & 0xFF;
+    if (i >= HTTP_MAX_CLIENTS) return nullptr;
+    Client &c = clients[i];
+    return c.fd >= 0 && c.waiting && c.gen == id >> 8 ? &c : nullptr;
+  }
+
+  void acceptClients() {
+    for (;;) {
+      int fd = accept(listenFd, nullptr, nullptr);
+      if (fd < 0) return;
+      Client *slot = nullptr;
+      for (Client &c : clients) if (c.fd < 0) { slot = &c; break; }
+      if (!slot || !halSockNonBlocking(fd)) { halSockClose(fd); rejected++; continue; }
+      slot->fd = fd;
+      slot->gen++;
+      slot->lastMs = millis64();
+    }
+  }
+
+  void drop(Client &c) {
+    while (c.outCount) {
+      FramePool::release(c.out[c.outHead].frame);
+      c.outHead = (c.outHead + 1) % HTTP_OUT_CHUNKS;
+      c.outCount--;
+    }
+    halSockClose(c.fd);
+    c.fd = -1;
+    c.ws = c.waiting = c.closing = false;
+    c.inLen = c.sent = 0;
+    c.outHead = 0;
+  }
+
+  bool queue(Client &c, const char *data, size_t len, SharedFrame *f, bool push) {
+    if (c.outCount == HTTP_OUT_CHUNKS) { FramePool::release(f); return false; }
+    c.out[(c.outHead + c.outCount++) % HTTP_OUT_CHUNKS] = { data, (uint16_t)len, f, push };
+    return true;
+  }
+
+  // A full queue drops its newest waiting push for this one
+  void push(Client &c, SharedFrame *f) {
+    FramePool::retain(f);
+    if (c.outCount == HTTP_OUT_CHUNKS) {
+      Chunk &tail = c.out[(c.outHead + c.outCount - 1) % HTTP_OUT_CHUNKS];
+      if (!tail.push) { FramePool::release(f); return; }
+      FramePool::release(tail.frame);
+      tail = { f->body(), (uint16_t)f->size(), f, true };
+      wsSkipped++;
+      return;
+    }
+    queue(c, f->body(), f->size(), f, true);
+    wsFrames++;
+  }
+
+  void answered(Client &c) {
+    c.waiting = false;
+    c.closing = true;
+  }
+
+  void flush(Client &c) {
+    while (c.outCount) {
+      Chunk &k = c.out[c.outHead];
+      int n = halSockSend(c.fd, k.data + c.sent, k.len - c.sent);
+      if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) drop(c);
+        return;
+      }
+      c.sent += n;
+      c.lastMs = millis64();
+      if (c.sent < k.len) return;
+      FramePool::release(k.frame);
+      c.outHead = (c.outHead + 1) % HTTP_OUT_CHUNKS;
+      c.outCount--;
+      c.sent = 0;
+    }
+    if (c.closing) drop(c);
+  }
+
+  void receive(Client &c) {
+    int n = recv(c.fd, c.in + c.inLen, HTTP_REQ_MAX - c.inLen, 0);
+    if (n <= 0) {
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+      drop(c);   // peer closed or reset
+      return;
+    }
+    c.inLen += n;
+    c.lastMs = millis64();
+    if (c.ws) receiveFrames(c);
+    else parseRequest(c);
+  }
+
+  void fail(Client &c, int status, const char *why) {
+    c.waiting = true;
+    respondText(c.gen << 8 | (&c - clients), status, why);
+  }
+
+  void parseRequest(Client &c) {
+    c.in[c.inLen] = '\0';
+    char *headEnd = strstr(c.in, "\r\n\r\n");
+    if (!headEnd) {
+      if (c.inLen >= HTTP_REQ_MAX) fail(c, 413, "headers too long");
+      return;
+    }
+    size_t headLen = headEnd + 4 - c.in, len = 0, bodyLen = 0;
+    const char *v = ws_detail::header(c.in, headEnd, "Content-Length", len);
+    if (v) bodyLen = strtoul(v, nullptr, 10);
+    if (headLen + bodyLen > HTTP_REQ_MAX) { fail(c, 413, "body too long"); return; }
+    if (c.inLen < headLen + bodyLen) return;   // rest of the body still to come
+    c.in[headLen + bodyLen] = '\0';
+    requests++;
+
+    char *method = c.in, *path = strchr(c.in, ' '), *proto = path ? strchr(path + 1, ' ') : nullptr;
+    if (!proto || proto > headEnd) { fail(c, 400, "malformed request line"); return; }
+    *path++ = '\0';
+    *proto = '\0';
+
+    const char *upgrade = ws_detail::header(proto + 1, headEnd, "Upgrade", len);
+    bool wantsWs = upgrade && len == 9 && !strncasecmp(upgrade, "websocket", 9);
+    const char *key = ws_detail::header(proto + 1, headEnd, "Sec-WebSocket-Key", len);
+    if (wantsWs && wsRoute && !strcmp(path, wsRoute) && !strcmp(method, "GET") && key && len < 64) {
+      openWebSocket(c, key, len);
+      return;
+    }
+
+    c.waiting = true;
+    HttpRequest req = { (uint16_t)(c.gen << 8 | (&c - clients)), method, path, c.in + headLen, bodyLen };
+    handler(handlerCtx, req);
+  }
+
+  void openWebSocket(Client &c, const char *key, size_t keyLen) {
+    static const char GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    uint8_t joined[64 + sizeof(GUID)], digest[20];
+    memcpy(joined, key, keyLen);
+    memcpy(joined + keyLen, GUID, sizeof(GUID) - 1);
+    ws_detail::sha1(joined, keyLen + sizeof(GUID) - 1, digest);
+    char accept[32];
+    ws_detail::base64(digest, sizeof(digest), accept);
+
+    SharedFrame *f = pool.acquire();
+    if (!f) { drop(c); return; }
+    f->appendf("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+               "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+    queue(c, f->body(), f->size(), f, false);
+    c.ws = true;
+    c.inLen = 0;
+    if (latest) push(c, latest);
+  }
+
+  // Client frames are masked and small; pings are answered, a close is
+  // echoed, and anything else from the page is ignored.
+  void receiveFrames(Client &c) {
+    uint8_t *p = (uint8_t *)c.in;
+    while (c.inLen >= 2) {
+      uint8_t op = p[0] & 0x0F;
+      size_t len = p[1] & 0x7F, hl = 2;
+      if (!(p[1] & 0x80) || len == 127) { drop(c); return; }
+      if (len == 126) {
+        if (c.inLen < 4) return;
+        len = p[2] << 8 | p[3];
+        hl = 4;
+      }
+      hl += 4;   // masking key
+      if (hl + len > HTTP_REQ_MAX) { drop(c); return; }
+      if (c.inLen < hl + len) return;
+      uint8_t *data = p + hl;
+      for (size_t i = 0; i < len; i++) data[i] ^= p[hl - 4 + (i & 3)];
+
+      if (op == 0x8 || op == 0x9) {
+        SharedFrame *f = pool.acquire();
+        if (!f) { drop(c); return; }
+        char hdr[2] = { (char)(0x80 | (op == 0x8 ? 0x8 : 0xA)), (char)(len < 126 ? len : 0) };
+        f->append(hdr, 2);
+        if (len < 126) f->append((const char *)data, len);
+        queue(c, f->body(), f->size(), f, false);
+        if (op == 0x8) { c.closing = true; return; }
+      }
+      memmove(p, p + hl + len, c.inLen - hl - len);
+      c.inLen -= hl + len;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef IRRIGATION_H
+#define IRRIGATION_H
+
+#include <algorithm>
+#include "Config.h"
+#include "Hal.h"
+
+#define IRR_QUEUE_MAX  (MAX_ROOMS * ROOM_MAX_ZONES)
+
+// ---------- Shared-supply flood scheduler ----------
+// Every zone floods from one reservoir, feed line and PSU. Instead of
+// opening its relay, a dry zone submits a request: priority (how far
+// below target it is), flood length, its current draw and a deadline.
+// poll() grants the best request that fits both IRR_MAX_ACTIVE and
+// IRR_SUPPLY_MA, so pumps start one at a time in priority order and
+// never overload the supply. A request past its deadline outranks every
+// request that is still on time, so a slightly dry zone cannot be
+// starved by a thirstier one. With nothing running, the head request is
+// granted even if its own draw exceeds the budget, so it cannot wait
+// forever.
+//
+// The queue is a binary heap in a fixed array, rebuilt when priorities
+// change or a deadline passes; it holds one entry per zone at most.
+// Everything runs in the control task.
+
+struct FloodRequest {
+  bool       (*start)(void *ctx, uint8_t zone);   // opens the zone; false if it cannot yet
+  void        *ctx;
+  uint8_t      zone;
+  const char  *name;          // zone name, for `floods`
+  int32_t      priority;      // dryness below target (0.1 %), higher first
+  uint32_t     durationMs;
+  uint16_t     currentMa;
+  uint64_t     submittedMs;
+  uint64_t     deadlineMs;    // start by then or jump the queue
+};
+
+// Queue wait and grant counters for one zone
+struct FloodWaitStats {
+  const char *name = nullptr;
+  uint32_t    grants = 0, late = 0;     // late: granted after the deadline
+  uint64_t    totalWaitMs = 0;
+  uint32_t    maxWaitMs = 0;
+};
+
+class IrrigationScheduler {
+public:
+  // Add or refresh a zone's request. A queued request keeps its place in
+  // time (submit time and deadline) and only takes the new priority.
+  void submit(const FloodRequest &r) {
+    FloodRequest *q = find(r.ctx, r.zone);
+    if (q) {
+      if (q->priority == r.priority) return;
+      q->priority = r.priority;
+      reorder();
+      return;
+    }
+    if (count >= IRR_QUEUE_MAX) return;
+    push(r, millis64());
+  }
+
+  // Withdraw a queued request, e.g. the zone is no longer dry
+  void cancel(void *ctx, uint8_t zone) {
+    FloodRequest *q = find(ctx, zone);
+    if (!q) return;
+    *q = heap[--count];
+    reorder();
+  }
+
+  bool queued(void *ctx, uint8_t zone) { return find(ctx, zone) != nullptr; }
+
+  // A granted flood has ended; its share of the supply is free again
+  void release(void *ctx, uint8_t zone) {
+    for (uint8_t i = 0; i < activeCount; i++) {
+      if (active[i].ctx != ctx || active[i].zone != zone) continue;
+      activeMa -= active[i].currentMa;
+      active[i] = active[--activeCount];
+      return;
+    }
+  }
+
+  // Scheduler task: grant what the supply allows, best request first
+  void poll() {
+    uint64_t now = millis64();
+    if (now >= nextDeadline) reorder();
+    while (count && activeCount < IRR_MAX_ACTIVE) {
+      const FloodRequest &top = heap[0];
+      if (activeCount && activeMa + top.currentMa > IRR_SUPPLY_MA) break;   // wait for the supply
+      FloodRequest r = top;
+      std::pop_heap(heap, heap + count, Before(now));
+      count--;
+      if (!r.start(r.ctx, r.zone)) {   // held back (e.g. relay min-run): back in line
+        push(r, now);
+        break;
+      }
+      active[activeCount++] = { r.ctx, r.zone, r.currentMa };
+      activeMa += r.currentMa;
+      if (activeCount > peakActive) peakActive = activeCount;
+      if (activeMa > peakMa) peakMa = activeMa;
+      record(r, now);
+    }
+  }
+
+  // Queued requests in grant order, for `floods`
+  uint8_t snapshot(FloodRequest *out) const {
+    Before before(millis64());
+    std::copy(heap, heap + count, out);
+    std::sort(out, out + count, [&before](const FloodRequest &a, const FloodRequest &b) { return before(b, a); });
+    return count;
+  }
+
+  uint8_t  size() const        { return count; }
+  uint8_t  running() const     { return activeCount; }
+  uint16_t runningMa() const   { return activeMa; }
+  uint8_t  peakRunning() const { return peakActive; }
+  uint16_t peakCurrent() const { return peakMa; }
+  uint8_t  statCount() const   { return statsUsed; }
+  const FloodWaitStats &stat(uint8_t i) const { return stats[i]; }
+
+private:
+  struct Active { void *ctx; uint8_t zone; uint16_t currentMa; };
+
+  // Heap order: overdue before on time, then the drier zone, then the
+  // longer wait. std heaps put the element that sorts last on top.
+  struct Before {
+    uint64_t now;
+    explicit Before(uint64_t n) : now(n) {}
+    bool operator()(const FloodRequest &a, const FloodRequest &b) const {
+      bool aLate = now >= a.deadlineMs, bLate = now >= b.deadlineMs;
+      if (aLate != bLate) return bLate;
+      if (aLate) return a.deadlineMs > b.deadlineMs;
+      if (a.priority != b.priority) return a.priority < b.priority;
+      return a.submittedMs > b.submittedMs;
+    }
+  };
+
+  FloodRequest   heap[IRR_QUEUE_MAX];
+  uint8_t        count = 0;
+  Active         active[IRR_QUEUE_MAX];
+  uint8_t        activeCount = 0;
+  uint16_t       activeMa = 0;
+  uint8_t        peakActive = 0;
+  uint16_t       peakMa = 0;
+  uint64_t       nextDeadline = UINT64_MAX;   // earliest on-time deadline in the queue
+  FloodWaitStats stats[IRR_QUEUE_MAX];
+  uint8_t        statsUsed = 0;
+
+  FloodRequest *find(void *ctx, uint8_t zone) {
+    for (uint8_t i = 0; i < count; i++)
+      if (heap[i].ctx == ctx && heap[i].zone == zone) return &heap[i];
+    return nullptr;
+  }
+
+  // Into the heap, and into nextDeadline so poll() reorders once it passes
+  void push(const FloodRequest &r, uint64_t now) {
+    heap[count++] = r;
+    std::push_heap(heap, heap + count, Before(now));
+    if (r.deadlineMs > now && r.deadlineMs < nextDeadline) nextDeadline = r.deadlineMs;
+  }
+
+  // Rebuild after a priority change, removal or deadline crossing
+  void reorder() {
+    uint64_t now = millis64();
+    std::make_heap(heap, heap + count, Before(now));
+    nextDeadline = UINT64_MAX;
+    for (uint8_t i = 0; i < count; i++)
+      if (heap[i].deadlineMs > now && heap[i].deadlineMs < nextDeadline) nextDeadline = heap[i].deadlineMs;
+  }
+
+  void record(const FloodRequest &r, uint64_t now) {
+    FloodWaitStats *s = nullptr;
+    for (uint8_t i = 0; i < statsUsed && !s; i++) if (stats[i].name == r.name) s = &stats[i];
+    if (!s) {
+      if (statsUsed >= IRR_QUEUE_MAX) return;
+      s = &stats[statsUsed++];
+      s->name = r.name;
+    }
+    uint32_t wait = (uint32_t)(now - r.submittedMs);
+    s->grants++;
+    s->totalWaitMs += wait;
+    if (wait > s->maxWaitMs) s->maxWaitMs = wait;
+    if (now > r.deadlineMs) s->late++;
+  }
+};
+
+extern IrrigationScheduler irrigation;
+
+#endif
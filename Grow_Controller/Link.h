@@ -0,0 +1,60 @@
+#ifndef LINK_H
+#define LINK_H
+
+#include <atomic>
+#include "SpscQueue.h"
+#include "Config.h"
+
+// ---------- Control <-> network link ----------
+// The control task (relays, rooms) and the network task (WiFi, Telegram,
+// OTA) run on separate cores and only talk through these queues. The web
+// task (Dashboard.h) and the MQTT task (MqttReporter.h) have their own
+// sets, so every queue keeps exactly one producer and one consumer.
+
+// control -> network: periodic snapshot of readings and outputs
+struct RoomTelemetry {
+  bool     sensorOk;
+  float    temp, hum;
+  float    soil[ROOM_MAX_ZONES];   // per flood zone, ROOM_TABLE order
+  uint32_t relays;                 // RelayController::states(), bit = Relay channel
+  uint8_t  floods;                 // bit = zone flooding now
+};
+
+struct Telemetry {
+  unsigned long stamp;
+  uint8_t       roomCount;
+  RoomTelemetry rooms[MAX_ROOMS];
+};
+
+// network -> control: one console command line (e.g. "set veg temp 25")
+struct CommandMsg {
+  char text[64];
+};
+
+// control -> network: the reply to one CommandMsg, empty if it printed nothing
+struct ReplyMsg {
+  char text[1024];
+};
+
+// control -> network: an event worth pushing to the chat unasked
+struct AlertMsg {
+  char text[96];
+};
+
+extern SpscQueue<Telemetry, 4>  telemetryQueue;
+extern SpscQueue<CommandMsg, 8> commandQueue;
+extern SpscQueue<ReplyMsg, 4>   replyQueue;
+extern SpscQueue<AlertMsg, 8>   alertQueue;
+extern SpscQueue<Telemetry, 2>  webTelemetryQueue;
+extern SpscQueue<CommandMsg, 4> webCommandQueue;
+extern SpscQueue<ReplyMsg, 4>   webReplyQueue;
+extern SpscQueue<Telemetry, 4>  mqttTelemetryQueue;
+extern SpscQueue<CommandMsg, 4> mqttCommandQueue;
+extern SpscQueue<ReplyMsg, 4>   mqttReplyQueue;
+
+extern std::atomic<bool> otaRequested;     // set by console, serviced by network task
+extern std::atomic<bool> netTaskRunning;
+extern std::atomic<bool> safeStateRequested;   // OTA asks the control task to park outputs
+extern std::atomic<bool> safeStateReached;     // control task has parked and stopped
+
+#endif
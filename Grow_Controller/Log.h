@@ -0,0 +1,246 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <stdarg.h>
+
+#define LOG_SLOTS          64     // ring size, power of two
+#define LOG_LINE_MAX       96     // longer lines are truncated
+#define LOG_MAX_SOURCES    16
+#define LOG_RATE_WINDOW_MS 1000
+#define LOG_RATE_BURST     12     // lines per source per window, 0 = unlimited
+#define LOG_DRAIN_PERIOD_MS 20
+#define LOG_FRAME_SYNC     0xA5
+
+// ---------- Asynchronous logger ----------
+// Producers format straight into a slot of a lock-free ring and return;
+// a low-priority drain task writes finished lines to the UART. A full
+// ring drops the line and counts it, so a slow or unplugged console never
+// holds up a relay decision. Any task (or timer callback) may log.
+//
+// Every line belongs to a LogSource, which carries a per-source rate
+// limit. Sources are registered from setup(), and each is only logged to
+// by the task that owns it, so its counters need no locking.
+//
+// Binary mode (`log binary`) replaces text with frames for capture tools:
+//   SYNC type len payload[len] sum      sum makes type+len+payload+sum == 0
+//   LOG_FRAME_LINE    u32 stamp ms, u8 level, u8 source, text
+//   LOG_FRAME_SOURCE  u8 source, name   (every source, when binary starts)
+//   LOG_FRAME_LOSS    u32 dropped, u32 suppressed (totals, when they change)
+// Console replies stay text; a reader resyncs on SYNC and the checksum.
+
+class Logger;
+
+enum LogLevel : uint8_t { LOG_ERROR, LOG_WARN, LOG_INFO, LOG_DEBUG };
+enum LogFrame : uint8_t { LOG_FRAME_LINE = 1, LOG_FRAME_SOURCE, LOG_FRAME_LOSS };
+
+const char *const LOG_LEVEL_NAMES[] = { "error", "warn", "info", "debug" };
+
+struct LogSource {
+  const char   *name;
+  uint8_t       id = 0xFF;         // set by Logger::add
+  uint8_t       burst;
+  uint8_t       used = 0;          // lines in the current window
+  unsigned long windowStart = 0;
+  uint32_t      windowSuppressed = 0;
+  uint32_t      suppressed = 0;    // total since boot
+
+  explicit LogSource(const char *n, uint8_t b = LOG_RATE_BURST) : name(n), burst(b) {}
+
+  // true if another line fits in this window; reports what the last one cut
+  bool admit(Logger &log);
+};
+
+#define LOG_VA(lvl) va_list ap; va_start(ap, fmt); vlog(s, lvl, fmt, ap); va_end(ap)
+
+class Logger {
+public:
+  std::atomic<uint8_t> level{LOG_INFO};
+  std::atomic<bool>    binary{false};
+
+  Logger() {
+    for (uint32_t i = 0; i < LOG_SLOTS; i++) slots[i].seq.store(i, std::memory_order_relaxed);
+  }
+
+  void add(LogSource &s) {
+    uint8_t n = sourceCount.load(std::memory_order_relaxed);
+    if (s.id != 0xFF || n >= LOG_MAX_SOURCES) return;
+    s.id = n;
+    sources[n] = &s;
+    sourceCount.store(n + 1, std::memory_order_release);   // the drain task may be reading
+  }
+
+  void error(LogSource &s, const char *fmt, ...) __attribute__((format(printf, 3, 4))) { LOG_VA(LOG_ERROR); }
+  void warn (LogSource &s, const char *fmt, ...) __attribute__((format(printf, 3, 4))) { LOG_VA(LOG_WARN); }
+  void info (LogSource &s, const char *fmt, ...) __attribute__((format(printf, 3, 4))) { LOG_VA(LOG_INFO); }
+  void debug(LogSource &s, const char *fmt, ...) __attribute__((format(printf, 3, 4))) { LOG_VA(LOG_DEBUG); }
+
+  void log(LogSource &s, LogLevel lvl, const char *fmt, ...) __attribute__((format(printf, 4, 5))) {
+    LOG_VA(lvl);
+  }
+
+  void vlog(LogSource &s, LogLevel lvl, const char *fmt, va_list ap) {
+    if (lvl > level.load(std::memory_order_relaxed)) return;
+    if (lvl > LOG_WARN && !s.admit(*this)) return;   // errors and warnings always get through
+    push(s, lvl, fmt, ap);
+  }
+
+  // Write out everything queued so far. Only the drain task calls this.
+  void drain(Print &out) {
+    bool bin = binary.load(std::memory_order_relaxed);
+    if (bin && !wasBinary) for (uint8_t i = 0; i < size(); i++) frameSource(out, i);
+    wasBinary = bin;
+
+    for (;;) {
+      Slot &slot = slots[tail & (LOG_SLOTS - 1)];
+      if (slot.seq.load(std::memory_order_acquire) != tail + 1) break;
+      const Record &r = slot.rec;
+      if (bin) frameLine(out, r);
+      else { out.write((const uint8_t *)r.text, r.len); out.write((const uint8_t *)"\r\n", 2); }
+      slot.seq.store(tail + LOG_SLOTS, std::memory_order_release);
+      tail++;
+      written++;
+    }
+
+    uint32_t d = dropped.load(std::memory_order_relaxed), sup = suppressedTotal();
+    if (d != reportedDrops || sup != reportedSuppressed) {
+      if (bin) frameLoss(out, d, sup);
+      else if (d != reportedDrops) out.printf("⚠️ log: %lu lines dropped (ring full)\r\n",
+                                               (unsigned long)(d - reportedDrops));
+      reportedDrops = d;
+      reportedSuppressed = sup;
+    }
+  }
+
+  uint32_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+  uint32_t writtenCount() const { return written; }
+  uint32_t pendingCount() const { return head.load(std::memory_order_relaxed) - tail; }
+  uint8_t  size() const { return sourceCount.load(std::memory_order_acquire); }
+  const LogSource &source(uint8_t i) const { return *sources[i]; }
+
+  uint32_t suppressedTotal() const {
+    uint32_t n = 0;
+    for (uint8_t i = 0, c = size(); i < c; i++) n += sources[i]->suppressed;
+    return n;
+  }
+
+  static bool parseLevel(const char *s, LogLevel &out) {
+    for (uint8_t i = 0; i <= LOG_DEBUG; i++)
+      if (!strcasecmp(s, LOG_LEVEL_NAMES[i])) { out = (LogLevel)i; return true; }
+    return false;
+  }
+
+private:
+  struct Record {
+    uint32_t stamp;
+    uint8_t  level, source, len;
+    char     text[LOG_LINE_MAX];
+  };
+  // Bounded MPSC ring: seq == pos means free for the producer claiming pos,
+  // pos + 1 means filled, pos + LOG_SLOTS frees it for the next lap.
+  struct Slot {
+    std::atomic<uint32_t> seq;
+    Record                rec;
+  };
+
+  static_assert((LOG_SLOTS & (LOG_SLOTS - 1)) == 0, "LOG_SLOTS must be a power of two");
+
+  Slot                  slots[LOG_SLOTS];
+  std::atomic<uint32_t> head{0};
+  std::atomic<uint32_t> dropped{0};
+  uint32_t              tail = 0;          // drain task only
+  uint32_t              written = 0;
+  uint32_t              reportedDrops = 0, reportedSuppressed = 0;
+  bool                  wasBinary = false;
+  LogSource            *sources[LOG_MAX_SOURCES];
+  std::atomic<uint8_t>  sourceCount{0};
+
+  void push(LogSource &s, LogLevel lvl, const char *fmt, va_list ap) {
+    uint32_t pos = head.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;) {
+      slot = &slots[pos & (LOG_SLOTS - 1)];
+      int32_t diff = (int32_t)(slot->seq.load(std::memory_order_acquire) - pos);
+      if (diff == 0) {
+        if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        dropped.fetch_add(1, std::memory_order_relaxed);   // full: never wait for the drain
+        return;
+      } else {
+        pos = head.load(std::memory_order_relaxed);
+      }
+    }
+    Record &r = slot->rec;
+    int n = vsnprintf(r.text, sizeof(r.text), fmt, ap);
+    r.len    = n < 0 ? 0 : (n < (int)sizeof(r.text) ? n : sizeof(r.text) - 1);
+    while (r.len && (r.text[r.len - 1] == '\n' || r.text[r.len - 1] == '\r')) r.len--;
+    r.stamp  = millis();
+    r.level  = lvl;
+    r.source = s.id;
+    slot->seq.store(pos + 1, std::memory_order_release);
+  }
+
+  // ---- Binary frames ----
+  static void frame(Print &out, uint8_t type, const uint8_t *a, uint8_t na,
+                    const uint8_t *b = nullptr, uint8_t nb = 0) {
+    uint8_t hdr[3] = { LOG_FRAME_SYNC, type, (uint8_t)(na + nb) };
+    uint8_t sum = type + hdr[2];
+    for (uint8_t i = 0; i < na; i++) sum += a[i];
+    for (uint8_t i = 0; i < nb; i++) sum += b[i];
+    sum = -sum;
+    out.write(hdr, 3);
+    out.write(a, na);
+    if (nb) out.write(b, nb);
+    out.write(&sum, 1);
+  }
+
+  static void put32(uint8_t *p, uint32_t v) {
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+  }
+
+  void frameLine(Print &out, const Record &r) {
+    uint8_t head[6];
+    put32(head, r.stamp);
+    head[4] = r.level;
+    head[5] = r.source;
+    frame(out, LOG_FRAME_LINE, head, sizeof(head), (const uint8_t *)r.text, r.len);
+  }
+
+  void frameSource(Print &out, uint8_t i) {
+    uint8_t id = i;
+    const char *name = sources[i]->name;
+    frame(out, LOG_FRAME_SOURCE, &id, 1, (const uint8_t *)name, strnlen(name, 32));
+  }
+
+  void frameLoss(Print &out, uint32_t d, uint32_t sup) {
+    uint8_t p[8];
+    put32(p, d);
+    put32(p + 4, sup);
+    frame(out, LOG_FRAME_LOSS, p, sizeof(p));
+  }
+};
+
+#undef LOG_VA
+
+extern Logger logger;
+
+inline bool LogSource::admit(Logger &log) {
+  if (!burst) return true;
+  unsigned long now = millis();
+  if (now - windowStart >= LOG_RATE_WINDOW_MS) {
+    windowStart = now;
+    used = 0;
+    if (windowSuppressed) {
+      uint32_t n = windowSuppressed;
+      windowSuppressed = 0;
+      log.warn(*this, "⚠️ %s: %lu lines suppressed (rate limit)", name, (unsigned long)n);
+    }
+  }
+  if (used < burst) { used++; return true; }
+  windowSuppressed++;
+  suppressed++;
+  return false;
+}
+
+#endif
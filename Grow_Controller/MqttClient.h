@@ -0,0 +1,313 @@
+#ifndef MQTTCLIENT_H
+#define MQTTCLIENT_H
+
+#include "Hal.h"
+#include "Backoff.h"
+
+#define MQTT_PACKET_MAX      1280     // largest packet sent or accepted
+#define MQTT_TX_BYTES        (2 * MQTT_PACKET_MAX)
+#define MQTT_KEEPALIVE_S     60
+#define MQTT_CONNECT_MS      10000    // TCP connect plus CONNACK
+#define MQTT_ACK_MS          15000    // PUBACK wait before the link counts as dead
+#define MQTT_BACKOFF_MIN_MS  2000
+#define MQTT_BACKOFF_MAX_MS  300000UL
+
+// ---------- MQTT 3.1.1 client ----------
+// Just what the reporter needs, over a non-blocking socket: CONNECT with
+// a clean session, a retained "offline" will and "online" once up, one
+// subscription, QoS 0/1 publishes with a single QoS 1 message in flight,
+// inbound QoS 0/1 publishes (QoS 2 is granted as 1) and keepalive pings.
+// poll() never blocks beyond its select() and DNS; a failed connect,
+// lost socket, missing PUBACK or silent broker closes the link and the
+// next attempt waits out a doubling backoff.
+//
+// With a clean session the broker forgets an unacknowledged publish when
+// the link drops, so the caller sends it again after reconnecting
+// (at-least-once delivery).
+
+struct MqttOptions {
+  const char *host;
+  uint16_t    port;
+  const char *clientId;
+  const char *user;          // empty: no credentials
+  const char *pass;
+  const char *statusTopic;   // retained "online", will "offline"
+  const char *subTopic;      // nullptr: none
+  void (*onMessage)(void *ctx, const char *topic, const uint8_t *payload, size_t len);
+  void       *ctx;
+};
+
+class MqttClient {
+public:
+  enum State : uint8_t { MQTT_DOWN, MQTT_TCP, MQTT_CONNACK, MQTT_UP };
+
+  State    state = MQTT_DOWN;
+  uint32_t connects = 0, drops = 0;
+  const char *lastError = "";   // why the link last went down
+
+  void begin(const MqttOptions &o) { opt = o; }
+
+  bool up() const   { return state == MQTT_UP; }
+  bool busy() const { return inflightId != 0; }   // a QoS 1 publish awaits its PUBACK
+
+  // True once for every PUBACK of the publish in flight
+  bool takeAck() {
+    bool a = acked;
+    acked = false;
+    return a;
+  }
+
+  // Connect, read and keep alive; sleeps in select() for up to waitMs
+  // while a socket is open. False if it did not wait (no socket).
+  bool poll(uint32_t waitMs, bool linkUp) {
+    if (!linkUp) { if (fd >= 0) fail("network down"); return false; }
+    if (fd < 0) {
+      if (!backoff.ready() || !open()) return false;
+    }
+    uint64_t now = millis64();
+    if (state != MQTT_UP && now - startedMs > MQTT_CONNECT_MS) { fail("connect timeout"); return false; }
+    if (state == MQTT_UP) {
+      if (busy() && now - sentMs > MQTT_ACK_MS) { fail("no PUBACK"); return false; }
+      if (now - rxMs > MQTT_KEEPALIVE_S * 1500UL) { fail("broker silent"); return false; }
+      if (now - txMs >= MQTT_KEEPALIVE_S * 500UL && !txLen) { uint8_t ping[2] = { 0xC0, 0 }; queue(ping, 2); }
+    }
+
+    fd_set rd, wr;
+    FD_ZERO(&rd);
+    FD_ZERO(&wr);
+    FD_SET(fd, &rd);
+    if (state == MQTT_TCP || txLen) FD_SET(fd, &wr);
+    struct timeval tv = { (long)(waitMs / 1000), (long)(waitMs % 1000) * 1000 };
+    if (select(fd + 1, &rd, &wr, nullptr, &tv) < 0) { fail("select"); return true; }
+
+    if (state == MQTT_TCP && FD_ISSET(fd, &wr)) {
+      int err = 0;
+      socklen_t len = sizeof(err);
+      if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) || err) { fail("connect refused"); return true; }
+      sendConnect();
+    }
+    if (fd >= 0 && FD_ISSET(fd, &rd)) receive();
+    if (fd >= 0 && txLen) flush();
+    return true;
+  }
+
+  // False if not up, the transmit buffer is full or (QoS 1) another
+  // publish is still in flight
+  bool publish(const char *topic, const void *payload, size_t len, bool qos1, bool retain = false, bool dup = false) {
+    if (!up() || (qos1 && busy())) return false;
+    size_t tlen = strlen(topic);
+    size_t rem = 2 + tlen + (qos1 ? 2 : 0) + len;
+    uint8_t flags = (dup ? 0x08 : 0) | (qos1 ? 0x02 : 0) | (retain ? 0x01 : 0);
+    if (!start(0x30 | flags, rem)) return false;
+    putStr(topic, tlen);
+    if (qos1) {
+      if (++nextId == 0) nextId = 1;
+      inflightId = nextId;
+      sentMs = millis64();
+      put16(inflightId);
+    }
+    putBytes(payload, len);
+    flush();
+    return true;
+  }
+
+  void disconnect() {
+    if (fd < 0) return;
+    if (up()) {
+      uint8_t bye[2] = { 0xE0, 0 };
+      txLen = 0;
+      queue(bye, 2);
+      flush();
+    }
+    close();
+  }
+
+private:
+  MqttOptions opt = {};
+  int         fd = -1;
+  Backoff     backoff{MQTT_BACKOFF_MIN_MS, MQTT_BACKOFF_MAX_MS};
+  uint64_t    startedMs = 0, rxMs = 0, txMs = 0, sentMs = 0;
+  uint16_t    nextId = 0, inflightId = 0;
+  bool        acked = false;
+  uint8_t     tx[MQTT_TX_BYTES];
+  size_t      txLen = 0;
+  uint8_t     rx[MQTT_PACKET_MAX];
+  size_t      rxLen = 0;
+
+  bool open() {
+    struct sockaddr_in addr;
+    if (!halResolve(opt.host, opt.port, addr)) { lastError = "DNS"; backoff.fail(); return false; }
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || !halSockNonBlocking(fd)) { fail("socket"); return false; }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) && errno != EINPROGRESS) {
+      fail("connect");
+      return false;
+    }
+    state = MQTT_TCP;
+    startedMs = rxMs = txMs = millis64();
+    txLen = rxLen = 0;
+    inflightId = 0;
+    acked = false;
+    return true;
+  }
+
+  void close() {
+    if (fd >= 0) halSockClose(fd);
+    fd = -1;
+    state = MQTT_DOWN;
+    inflightId = 0;
+    txLen = rxLen = 0;
+  }
+
+  void fail(const char *why) {
+    lastError = why;
+    if (state == MQTT_UP) drops++;
+    close();
+    backoff.fail();
+  }
+
+  // ---------- Packet building ----------
+  // Fixed header; false (nothing queued) if the whole packet will not fit
+  bool start(uint8_t type, size_t rem) {
+    uint8_t hdr[5];
+    size_t n = 0, left = rem;
+    hdr[n++] = type;
+    do {
+      uint8_t b = left % 128;
+      left /= 128;
+      hdr[n++] = left ? b | 0x80 : b;
+    } while (left && n < 5);
+    return !left && txLen + n + rem <= MQTT_TX_BYTES && queue(hdr, n);
+  }
+
+  bool queue(const void *p, size_t n) {
+    if (txLen + n > MQTT_TX_BYTES) return false;
+    memcpy(tx + txLen, p, n);
+    txLen += n;
+    return true;
+  }
+
+  void put16(uint16_t v) { uint8_t b[2] = { (uint8_t)(v >> 8), (uint8_t)v }; queue(b, 2); }
+  void putStr(const char *s, size_t n) { put16((uint16_t)n); queue(s, n); }
+  void putBytes(const void *p, size_t n) { queue(p, n); }
+
+  void flush() {
+    int n = halSockSend(fd, tx, txLen);
+    if (n < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) fail("send");
+      return;
+    }
+    memmove(tx, tx + n, txLen - n);
+    txLen -= n;
+    txMs = millis64();
+  }
+
+  void sendConnect() {
+    static const char WILL[] = "offline";
+    bool auth = opt.user && *opt.user;
+    size_t idLen = strlen(opt.clientId), willLen = strlen(opt.statusTopic);
+    size_t rem = 10 + 2 + idLen + 2 + willLen + 2 + strlen(WILL);
+    if (auth) rem += 2 + strlen(opt.user) + 2 + strlen(opt.pass);
+    // clean session, will QoS 1 retained, credentials when set
+    uint8_t flags = 0x02 | 0x04 | 0x08 | 0x20 | (auth ? 0xC0 : 0);
+    uint8_t var[10] = { 0, 4, 'M', 'Q', 'T', 'T', 4, flags, 0, MQTT_KEEPALIVE_S };
+    start(0x10, rem);
+    queue(var, sizeof(var));
+    putStr(opt.clientId, idLen);
+    putStr(opt.statusTopic, willLen);
+    putStr(WILL, strlen(WILL));
+    if (auth) {
+      putStr(opt.user, strlen(opt.user));
+      putStr(opt.pass, strlen(opt.pass));
+    }
+    state = MQTT_CONNACK;
+    flush();
+  }
+
+  void onConnected() {
+    state = MQTT_UP;
+    connects++;
+    backoff.ok();
+    if (opt.subTopic) {
+      size_t n = strlen(opt.subTopic);
+      start(0x82, 2 + 2 + n + 1);
+      put16(1);
+      putStr(opt.subTopic, n);
+      uint8_t qos = 1;
+      queue(&qos, 1);
+    }
+    publish(opt.statusTopic, "online", 6, false, true);
+  }
+
+  // ---------- Packet parsing ----------
+  void receive() {
+    int n = recv(fd, rx + rxLen, sizeof(rx) - rxLen, 0);
+    if (n <= 0) {
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+      fail("closed by broker");
+      return;
+    }
+    rxLen += n;
+    rxMs = millis64();
+
+    size_t used = 0;
+    while (fd >= 0) {
+      size_t rem = 0, pos = used + 1;
+      uint32_t mul = 1;
+      bool whole = false;
+      while (pos < rxLen && pos - used <= 4) {
+        uint8_t b = rx[pos++];
+        rem += (b & 0x7F) * mul;
+        mul *= 128;
+        if (!(b & 0x80)) { whole = true; break; }
+      }
+      if (!whole) {
+        if (pos - used > 4) fail("bad length");
+        break;
+      }
+      if (pos - used + rem > sizeof(rx)) { fail("packet too large"); return; }
+      if (pos + rem > rxLen) break;
+      handle(rx[used], rx + pos, rem);
+      used = pos + rem;
+    }
+    if (fd < 0) return;
+    memmove(rx, rx + used, rxLen - used);
+    rxLen -= used;
+  }
+
+  void handle(uint8_t type, const uint8_t *p, size_t n) {
+    switch (type >> 4) {
+      case 2:   // CONNACK
+        if (state == MQTT_CONNACK && n >= 2 && p[1] == 0) onConnected();
+        else fail("refused");
+        break;
+      case 3: {   // PUBLISH
+        uint8_t qos = (type >> 1) & 3;
+        if (n < 2) break;
+        size_t tlen = (size_t)p[0] << 8 | p[1];
+        size_t off = 2 + tlen + (qos ? 2 : 0);
+        if (off > n) break;
+        char topic[64];
+        size_t tcopy = tlen < sizeof(topic) - 1 ? tlen : sizeof(topic) - 1;
+        memcpy(topic, p + 2, tcopy);
+        topic[tcopy] = '\0';
+        if (opt.onMessage) opt.onMessage(opt.ctx, topic, p + off, n - off);
+        if (qos) {
+          uint8_t ack[4] = { 0x40, 2, p[2 + tlen], p[3 + tlen] };
+          queue(ack, sizeof(ack));
+        }
+        break;
+      }
+      case 4:   // PUBACK
+        if (n >= 2 && ((uint16_t)p[0] << 8 | p[1]) == inflightId && inflightId) {
+          inflightId = 0;
+          acked = true;
+        }
+        break;
+      default:   // SUBACK, PINGRESP: rxMs already shows the broker is alive
+        break;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,302 @@
+#ifndef MQTTREPORTER_H
+#define MQTTREPORTER_H
+
+#include <Preferences.h>
+#include "MqttClient.h"
+#include "Spool.h"
+#include "Link.h"
+#include "Rooms.h"
+#include "Log.h"
+
+// --- broker ---
+#define MQTT_HOST        "192.168.1.10"
+#define MQTT_PORT        1883
+#define MQTT_USER        ""             // empty: anonymous
+#define MQTT_PASS        ""
+#define MQTT_DEVICE      "greenhouse"   // topics are grow/<device>/...
+
+#define MQTT_SAMPLE_MS   10000   // one reading per room goes into the batch this often
+#define MQTT_BATCH_MS    60000   // a batch is sealed at least this often
+#define MQTT_BATCH_MAX   1024    // payload bytes; a full batch is sealed early
+#define MQTT_ENTRY_MAX   160     // one reading, relay or flood entry
+#define MQTT_SEQ_BLOCK   1000    // batch seqs reserved in NVS at a time
+#define MQTT_NS          "mqtt"
+#define MQTT_SEQ_KEY     "seq"   // first seq not yet reserved
+
+static_assert(MQTT_BATCH_MAX + 64 <= MQTT_PACKET_MAX, "a batch must fit one packet");
+
+// ---------- MQTT telemetry ----------
+// Runs in its own task (NetTask.h). Readings, relay transitions and
+// finished floods from both rooms are packed into one JSON batch per
+// MQTT_BATCH_MS and published with QoS 1 on grow/<device>/tele:
+//
+//   {"dev":"greenhouse","seq":42,"t0":3600,"wall":1767229200,"b":[
+//     [0,"r","veg",25.1,60.2,[41.5,38.0]],    reading: temp, hum, zone soil %
+//     [12,"e","flower","heater",1],           relay on (1) or off (0)
+//     [95,"f","veg","mother",30]]}            flood finished, seconds open
+//
+// t is seconds after t0 (uptime, s); wall is local wall time when the
+// clock is set. Edges and floods are found by comparing the 1 Hz
+// telemetry snapshots, so a relay that switches back within a second
+// goes unseen; floods last tens of seconds at least.
+//
+// A sealed batch is published straight from RAM when the link is up,
+// idle and nothing is spooled. Otherwise it goes to the flash spool
+// (Spool.h), which is replayed oldest first, one QoS 1 publish at a
+// time, whenever the link is back; a batch whose PUBACK never came is
+// spooled too. seq rises across resets, so a consumer can drop the
+// duplicates that at-least-once delivery allows: seqs are reserved in
+// NVS MQTT_SEQ_BLOCK at a time before any is used, and boot starts at
+// the next unreserved one, whether or not the last batches reached the
+// spool.
+//
+// Messages on grow/<device>/cmd are console commands, served by
+// handleSerial() like Telegram's and answered on grow/<device>/reply.
+
+class MqttReporter {
+public:
+  MqttClient client;
+  Spool      spool;
+  uint32_t   sealed = 0, sentLive = 0, replayed = 0, lost = 0, commands = 0;
+
+  void begin(const char *host = MQTT_HOST, uint16_t port = MQTT_PORT) {
+    logger.add(logSrc);
+    if (spool.begin())
+      logger.info(logSrc, "✅ Spool %lu KB, %lu batches waiting", (unsigned long)(spool.bytes() / 1024),
+                  (unsigned long)spool.pending());
+    else
+      logger.warn(logSrc, "⚠️ No spool partition, batches are lost while offline");
+    Preferences nvs;   // not the shared `prefs`: this runs in the MQTT task
+    nvs.begin(MQTT_NS, true);
+    nextSeq = nvs.getUInt(MQTT_SEQ_KEY, 1);
+    nvs.end();
+    if (spool.lastSeq() >= nextSeq) nextSeq = spool.lastSeq() + 1;
+    reserveSeqs();
+    snprintf(topicTele, sizeof(topicTele), "grow/%s/tele", MQTT_DEVICE);
+    snprintf(topicStatus, sizeof(topicStatus), "grow/%s/status", MQTT_DEVICE);
+    snprintf(topicCmd, sizeof(topicCmd), "grow/%s/cmd", MQTT_DEVICE);
+    snprintf(topicReply, sizeof(topicReply), "grow/%s/reply", MQTT_DEVICE);
+    snprintf(clientId, sizeof(clientId), "grow-%s", MQTT_DEVICE);
+    MqttOptions o = { host, port, clientId, MQTT_USER, MQTT_PASS, topicStatus, topicCmd, onMessage, this };
+    client.begin(o);
+  }
+
+  // MQTT task: batch new telemetry, move replies and batches, then serve
+  // the socket for up to waitMs. False if it did not wait.
+  bool poll(uint32_t waitMs, bool linkUp) {
+    Telemetry t;
+    while (mqttTelemetryQueue.pop(t)) take(t);
+    if (batchLen && millis64() - batchOpenMs >= MQTT_BATCH_MS) seal();
+
+    bool wasUp = client.up();
+    bool waited = client.poll(waitMs, linkUp);
+    if (client.up() != wasUp) {
+      if (client.up()) logger.info(logSrc, "✅ Broker connected, %lu batches to replay", (unsigned long)spool.pending());
+      else logger.warn(logSrc, "⚠️ Broker lost (%s), spooling", client.lastError);
+    }
+
+    if (client.takeAck()) delivered();
+    if (!client.up()) {
+      if (ramLen) spoolRam();   // its PUBACK never came
+      sending = SEND_NONE;
+    }
+    sendNext();
+    sendReply();
+    return waited;
+  }
+
+  uint32_t lastSeq() const { return nextSeq - 1; }   // newest batch seq handed out
+
+private:
+  enum Sending : uint8_t { SEND_NONE, SEND_RAM, SEND_SPOOL };
+
+  LogSource logSrc{"mqtt"};
+  char      topicTele[40], topicStatus[40], topicCmd[40], topicReply[40], clientId[32];
+
+  Telemetry prev = {};
+  bool      havePrev = false;
+  unsigned long floodStart[MAX_ROOMS][ROOM_MAX_ZONES] = {};
+  unsigned long lastSample = 0;
+
+  char      batch[MQTT_BATCH_MAX];   // being filled
+  size_t    batchLen = 0;
+  uint64_t  batchOpenMs = 0;
+  unsigned long batchT0 = 0;         // uptime s of the first entry
+  uint32_t  batchSeq = 0;
+
+  char      ram[MQTT_BATCH_MAX];     // sealed, published from RAM
+  size_t    ramLen = 0;
+  uint32_t  ramSeq = 0;
+
+  char      out[MQTT_BATCH_MAX];     // spool record being replayed
+  Sending   sending = SEND_NONE;
+  uint32_t  nextSeq = 1;
+  uint32_t  seqLimit = 0;            // first seq not reserved in NVS
+  uint32_t  lastTried = 0;           // seq of the last QoS 1 publish, for DUP
+
+  ReplyMsg  reply;
+  bool      haveReply = false;
+
+  // ---------- Batching ----------
+  void take(const Telemetry &t) {
+    for (uint8_t i = 0; i < t.roomCount && i < ROOM_COUNT; i++) {
+      const RoomTelemetry &rt = t.rooms[i];
+      const RoomDef &d = ROOM_TABLE[i];
+      if (!havePrev) {
+        for (uint8_t z = 0; z < d.zoneCount; z++) if (rt.floods >> z & 1) floodStart[i][z] = t.stamp;
+        continue;
+      }
+      const RoomTelemetry &was = prev.rooms[i];
+      uint32_t changed = rt.relays ^ was.relays;
+      for (uint8_t ch = 0; ch < ROOM_RELAY_COUNT; ch++)
+        if (changed >> ch & 1)
+          add(t.stamp, "\"e\",\"%s\",\"%s\",%d", d.name, relayLabel(i, ch), (int)(rt.relays >> ch & 1));
+      for (uint8_t z = 0; z < d.zoneCount; z++) {
+        bool on = rt.floods >> z & 1, wasOn = was.floods >> z & 1;
+        if (on && !wasOn) floodStart[i][z] = t.stamp;
+        if (!on && wasOn)
+          add(t.stamp, "\"f\",\"%s\",\"%s\",%lu", d.name, d.zones[z].name,
+              (t.stamp - floodStart[i][z] + 500) / 1000);
+      }
+    }
+
+    if (!havePrev || t.stamp - lastSample >= MQTT_SAMPLE_MS) {
+      lastSample = t.stamp;
+      for (uint8_t i = 0; i < t.roomCount && i < ROOM_COUNT; i++) reading(t, i);
+    }
+    prev = t;
+    havePrev = true;
+  }
+
+  void reading(const Telemetry &t, uint8_t i) {
+    const RoomTelemetry &rt = t.rooms[i];
+    const RoomDef &d = ROOM_TABLE[i];
+    char temp[12] = "null", hum[12] = "null", soil[64] = "";
+    if (rt.sensorOk && !isnan(rt.temp)) snprintf(temp, sizeof(temp), "%.1f", rt.temp);
+    if (rt.sensorOk && !isnan(rt.hum)) snprintf(hum, sizeof(hum), "%.1f", rt.hum);
+    size_t n = 0;
+    for (uint8_t z = 0; z < d.zoneCount && n < sizeof(soil); z++)
+      n += isnan(rt.soil[z]) ? snprintf(soil + n, sizeof(soil) - n, "%snull", z ? "," : "")
+                             : snprintf(soil + n, sizeof(soil) - n, "%s%.1f", z ? "," : "", rt.soil[z]);
+    add(t.stamp, "\"r\",\"%s\",%s,%s,[%s]", d.name, temp, hum, soil);
+  }
+
+  // Append [t,<fmt>] to the open batch, sealing it first if full
+  void add(unsigned long stamp, const char *fmt, ...) __attribute__((format(printf, 3, 4))) {
+    char body[MQTT_ENTRY_MAX];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(body, sizeof(body), fmt, ap);
+    va_end(ap);
+    if (n < 0 || n >= (int)sizeof(body)) return;
+
+    // "[t," body "]", a separating comma and the closing "]}"
+    if (batchLen && batchLen + n + 16 > sizeof(batch)) seal();
+    if (!batchLen) open(stamp);
+    batchLen += snprintf(batch + batchLen, sizeof(batch) - batchLen, "%s[%lu,%s]",
+                         batch[batchLen - 1] == '[' ? "" : ",", stamp / 1000 - batchT0, body);
+  }
+
+  void open(unsigned long stamp) {
+    batchT0 = stamp / 1000;
+    batchOpenMs = millis64();
+    if (nextSeq >= seqLimit) reserveSeqs();
+    batchSeq = nextSeq++;
+    batchLen = snprintf(batch, sizeof(batch), "{\"dev\":\"%s\",\"seq\":%lu,\"t0\":%lu", MQTT_DEVICE,
+                        (unsigned long)batchSeq, batchT0);
+    uint64_t wallMs;
+    if (halWallMs(wallMs))
+      batchLen += snprintf(batch + batchLen, sizeof(batch) - batchLen, ",\"wall\":%llu",
+                           (unsigned long long)(wallMs / 1000));
+    batchLen += snprintf(batch + batchLen, sizeof(batch) - batchLen, ",\"b\":[");
+  }
+
+  // Claim the next MQTT_SEQ_BLOCK seqs before handing any out; a reset
+  // skips what is left of the block. One NVS write per block, about
+  // every 17 h at one batch a minute.
+  void reserveSeqs() {
+    seqLimit = nextSeq + MQTT_SEQ_BLOCK;
+    Preferences nvs;
+    bool ok = nvs.begin(MQTT_NS, false) && nvs.putUInt(MQTT_SEQ_KEY, seqLimit) == sizeof(uint32_t);
+    nvs.end();
+    if (!ok) logger.error(logSrc, "❌ Batch seq reservation failed, seqs may repeat after a reset");
+  }
+
+  // Close the batch and hand it to RAM (link idle, nothing older waiting)
+  // or the spool
+  void seal() {
+    memcpy(batch + batchLen, "]}", 2);
+    batchLen += 2;
+    sealed++;
+    if (ramLen) spoolRam();   // still unacknowledged: keep it ahead of this one
+    if (client.up() && !client.busy() && !spool.pending()) {
+      memcpy(ram, batch, batchLen);
+      ramLen = batchLen;
+      ramSeq = batchSeq;
+    } else if (!spool.append(batchSeq, batch, batchLen)) {
+      lost++;
+    }
+    batchLen = 0;
+  }
+
+  // The RAM batch joins the spool. The spool is empty behind it (RAM is
+  // only used then), so it stays the oldest record; a publish of it still
+  // in flight is now the spool's head.
+  void spoolRam() {
+    if (!spool.append(ramSeq, ram, ramLen)) lost++;
+    else if (sending == SEND_RAM) sending = SEND_SPOOL;
+    ramLen = 0;
+  }
+
+  // ---------- Sending ----------
+  void delivered() {
+    if (sending == SEND_RAM) { ramLen = 0; sentLive++; }
+    else if (sending == SEND_SPOOL) { spool.markSent(); replayed++; }
+    sending = SEND_NONE;
+  }
+
+  // One QoS 1 batch in flight: RAM first, it is only filled while the spool is empty
+  void sendNext() {
+    if (!client.up() || client.busy() || sending != SEND_NONE) return;
+    uint32_t seq;
+    if (ramLen) {
+      if (publishBatch(ram, ramLen, ramSeq)) sending = SEND_RAM;
+    } else if (size_t n = spool.peek(out, sizeof(out), seq)) {
+      if (publishBatch(out, n, seq)) sending = SEND_SPOOL;
+    }
+  }
+
+  bool publishBatch(const char *data, size_t len, uint32_t seq) {
+    bool dup = seq == lastTried;
+    if (!client.publish(topicTele, data, len, true, false, dup)) return false;
+    lastTried = seq;
+    return true;
+  }
+
+  // Replies from the control task go out as QoS 0; dropped while offline
+  void sendReply() {
+    if (!haveReply) haveReply = mqttReplyQueue.pop(reply);
+    if (!haveReply) return;
+    if (client.up()) {
+      size_t n = strlen(reply.text);
+      if (!n || client.publish(topicReply, reply.text, n, false)) haveReply = false;
+    } else {
+      haveReply = false;
+    }
+  }
+
+  static void onMessage(void *ctx, const char *topic, const uint8_t *payload, size_t len) {
+    MqttReporter *self = static_cast<MqttReporter *>(ctx);
+    if (strcmp(topic, self->topicCmd)) return;
+    CommandMsg cmd;
+    size_t n = len < sizeof(cmd.text) - 1 ? len : sizeof(cmd.text) - 1;
+    memcpy(cmd.text, payload, n);
+    cmd.text[n] = '\0';
+    if (mqttCommandQueue.push(cmd)) self->commands++;
+    else self->client.publish(self->topicReply, "busy, try again", 15, false);
+  }
+};
+
+extern MqttReporter mqttReporter;
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef NETTASK_H
+#define NETTASK_H
+
+#include "TelegramBot.h"
+#include "OTAUpdate.h"
+#include "Link.h"
+#include "Dashboard.h"
+#include "MqttReporter.h"
+#include "Power.h"
+
+// ---------- Network task (core 0) ----------
+// WiFi, Telegram long polling and OTA live here so a slow TLS handshake or a
+// flaky AP can never hold up the control task on the other core. With no
+// WiFi the controller simply runs offline until the link comes back.
+
+#define NET_CORE        0
+#define NET_PRIORITY    1
+#define NET_STACK       12288
+#define NET_TICK_MS     50
+
+// The dashboard gets its own task: a Telegram long poll may hold the
+// network task for BOT_LONG_POLL_S, the web server must not wait on it
+#define WEB_PRIORITY    1
+#define WEB_STACK       6144
+#define WEB_TICK_MS     20   // select() timeout, bounds reply and push latency
+
+// MQTT too: batches keep spooling while the broker or WiFi is down
+#define MQTT_PRIORITY   1
+#define MQTT_STACK      6144
+#define MQTT_TICK_MS    50   // select() timeout while connected, else the idle delay
+
+// Wall clock for the light schedule; POSIX TZ string, e.g.
+// "CET-1CEST,M3.5.0,M10.5.0/3" or "SAST-2"
+#define CLOCK_TZ        "UTC0"
+#define NTP_SERVER      "pool.ntp.org"
+
+Telemetry latestTelemetry = {};
+PowerTask powerNet, powerWeb, powerMqtt;
+
+void networkTask(void *) {
+  initTelegram();
+  netTaskRunning = true;
+
+  bool sntpStarted = false;
+  for (;;) {
+    wifi.poll();
+    if (wifi.up && !sntpStarted) {
+      configTzTime(CLOCK_TZ, NTP_SERVER);   // SNTP keeps the clock in the background
+      sntpStarted = true;
+    }
+
+    Telemetry t;
+    while (telemetryQueue.pop(t)) latestTelemetry = t;
+
+    if (otaRequested.exchange(false)) performOTA();
+
+    powerNet.asleep();   // the long poll waits on the socket
+    serviceTelegram();   // may block for one long poll; idle while offline
+    powerNet.awake();
+    power.idle(powerNet, power.period(NET_TICK_MS, POWER_NET_TICK_MS));
+  }
+}
+
+LogSource logWeb("web");
+
+void webTask(void *) {
+  const uint32_t tick = power.period(WEB_TICK_MS, POWER_WEB_TICK_MS);
+  for (;;) {
+    if (!dashboard.listening() && wifi.up && dashboard.begin(WEB_PORT))
+      logger.info(logWeb, "✅ Dashboard on http://%s:%d/", WiFi.localIP().toString().c_str(), WEB_PORT);
+    powerWeb.asleep();   // the whole poll counts as asleep, it is nearly all select()
+    if (dashboard.listening()) dashboard.poll(tick);
+    else halWaitWake(tick);
+    powerWeb.awake();
+  }
+}
+
+void mqttTask(void *) {
+  const uint32_t tick = power.period(MQTT_TICK_MS, POWER_MQTT_TICK_MS);
+  mqttReporter.begin();   // scans the spool, may take a moment
+  for (;;) {
+    powerMqtt.asleep();
+    if (!mqttReporter.poll(tick, wifi.up)) halWaitWake(tick);
+    powerMqtt.awake();
+  }
+}
+
+void startNetworkTask() {
+  logger.add(logWeb);
+  logger.add(logOta);
+  logger.add(logOtaStart);
+#if PERF_ENABLED
+  perf.add(perfBotSend, "tg send");
+#endif
+  power.add(powerNet, "net");
+  power.add(powerWeb, "web");
+  power.add(powerMqtt, "mqtt");
+  wifi.begin();   // returns at once, the driver connects in the background
+  xTaskCreatePinnedToCore(networkTask, "net", NET_STACK, nullptr, NET_PRIORITY, nullptr, NET_CORE);
+  xTaskCreatePinnedToCore(webTask, "web", WEB_STACK, nullptr, WEB_PRIORITY, nullptr, NET_CORE);
+  xTaskCreatePinnedToCore(mqttTask, "mqtt", MQTT_STACK, nullptr, MQTT_PRIORITY, nullptr, NET_CORE);
+}
+
+#endif
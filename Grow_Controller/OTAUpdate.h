@@ -1,65 +1,207 @@
-#ifndef OTAUPDATE_H
-#define OTAUPDATE_H
-
-#include <WiFi.h>
-#include <WiFiClientSecure.h>
-#include <HTTPClient.h>
-#include <Update.h>
-
-// === OTA CONFIG ===
-// Use your raw GitHub URL here:
-const char* OTA_URL =
-  "https://github.com/JannieDuiwel/Grow_Controller/raw/refs/heads/main/Grow_Controller.bin";
-
-void performOTA() {
-  Serial.println("🔁 Starting OTA update from GitHub RAW...");
-
-  WiFiClientSecure client;
-  client.setInsecure(); // bypass SSL cert verification for GitHub
-
-  HTTPClient https;
-  if (!https.begin(client, OTA_URL)) {
-    Serial.println("❌ HTTPS init failed");
-    return;
-  }
-
-  int httpCode = https.GET();
-  if (httpCode != HTTP_CODE_OK) {
-    Serial.printf("❌ HTTP failed, code: %d\n", httpCode);
-    https.end();
-    return;
-  }
-
-  int contentLength = https.getSize();
-  WiFiClient *stream = (WiFiClient *)https.getStreamPtr();
-
-  if (!Update.begin(contentLength)) {
-    Serial.println("❌ Not enough space for OTA");
-    https.end();
-    return;
-  }
-
-  Serial.printf("⬇️  Downloading %d bytes...\n", contentLength);
-  size_t written = Update.writeStream(*stream);
-
-  if (written == contentLength)
-    Serial.println("✅ Download complete");
-  else
-    Serial.printf("⚠️ Written only %d/%d bytes\n", written, contentLength);
-
-  if (Update.end()) {
-    if (Update.isFinished()) {
-      Serial.println("🎉 OTA successful, rebooting...");
-      delay(1000);
-      ESP.restart();
-    } else {
-      Serial.println("⚠️ OTA not finished");
-    }
-  } else {
-    Serial.printf("❌ OTA error #%u: %s\n", Update.getError(), Update.errorString());
-  }
-
-  https.end();
-}
-
-#endif
+#ifndef OTAUPDATE_H
+#define OTAUPDATE_H
+
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+#include <Update.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/pk.h>
+#include "Link.h"
+#include "Log.h"
+
+// === OTA CONFIG ===
+// Use your raw GitHub URL here; the detached signature sits next to it.
+const char* OTA_URL =
+  "https://github.com/JannieDuiwel/Grow_Controller/raw/refs/heads/main/Grow_Controller.bin";
+const char* OTA_SIG_URL =
+  "https://github.com/JannieDuiwel/Grow_Controller/raw/refs/heads/main/Grow_Controller.bin.sig";
+
+// Public half of the release signing key (ECDSA P-256 or RSA). Sign a build with
+//   openssl dgst -sha256 -sign ota_key.pem -out Grow_Controller.bin.sig Grow_Controller.bin
+// Until a real key is pasted here every update is refused.
+const char* OTA_PUBLIC_KEY =
+  "-----BEGIN PUBLIC KEY-----\n"
+  "PASTE-YOUR-PUBLIC-KEY-HERE\n"
+  "-----END PUBLIC KEY-----\n";
+
+// Root CA of the firmware host, or nullptr to skip the TLS check. The
+// signature is what decides whether an image may boot either way.
+const char* OTA_ROOT_CA = nullptr;
+
+#define OTA_CORE           0
+#define OTA_PRIORITY       1      // lowest app priority, control task is 3 on core 1
+#define OTA_STACK          10240  // mbedtls signature check needs the room
+#define OTA_CHUNK          4096   // one flash sector per write
+#define OTA_CHUNK_PAUSE_MS 5      // spreads flash erase/write stalls out
+#define OTA_STALL_MS       15000  // no data for this long aborts the download
+#define OTA_SIG_MAX        512
+#define OTA_PARK_WAIT_MS   2000   // how long to wait for the control task to park
+
+// ---------- Streaming, verified OTA ----------
+// Runs in its own low-priority task on the network core. The image is
+// written to the idle partition one chunk at a time and hashed as it
+// goes; the partition is only marked bootable once the byte count matches
+// and the SHA-256 verifies against the release signature. Anything else
+// aborts the update and the running firmware carries on untouched.
+
+std::atomic<bool> otaRunning{false};
+LogSource logOta("ota");        // the OTA task
+LogSource logOtaStart("ota");   // performOTA(), in the network task
+uint8_t otaChunk[OTA_CHUNK];   // static so the task stack only holds mbedtls
+
+// GET url; returns the content length, or -1 after logging why not.
+int otaOpen(HTTPClient &https, WiFiClientSecure &client, const char *url) {
+  if (OTA_ROOT_CA) client.setCACert(OTA_ROOT_CA);
+  else client.setInsecure();
+  https.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);   // raw links redirect
+  https.setTimeout(OTA_STALL_MS);
+  if (!https.begin(client, url)) {
+    logger.error(logOta, "❌ HTTPS init failed");
+    return -1;
+  }
+  int httpCode = https.GET();
+  if (httpCode != HTTP_CODE_OK) {
+    logger.error(logOta, "❌ HTTP failed, code: %d", httpCode);
+    return -1;
+  }
+  int len = https.getSize();
+  if (len <= 0) logger.error(logOta, "❌ Server sent no content length");
+  return len;
+}
+
+// Read exactly len bytes from stream, giving up after OTA_STALL_MS of silence.
+bool otaReadFully(WiFiClient *stream, uint8_t *dst, size_t len) {
+  size_t got = 0;
+  unsigned long lastData = millis();
+  while (got < len) {
+    int avail = stream->available();
+    if (avail > 0) {
+      got += stream->readBytes(dst + got, min((size_t)avail, len - got));
+      lastData = millis();
+    } else {
+      if (millis() - lastData >= OTA_STALL_MS) return false;
+      delay(1);
+    }
+  }
+  return true;
+}
+
+// Fetch the detached signature into sig; returns its length or 0.
+size_t otaFetchSignature(uint8_t *sig) {
+  WiFiClientSecure client;
+  HTTPClient https;
+  int len = otaOpen(https, client, OTA_SIG_URL);
+  size_t n = 0;
+  if (len > OTA_SIG_MAX) logger.error(logOta, "❌ Signature file too large");
+  else if (len > 0 && otaReadFully(https.getStreamPtr(), sig, len)) n = len;
+  https.end();
+  return n;
+}
+
+bool otaVerify(const uint8_t hash[32], const uint8_t *sig, size_t sigLen) {
+  mbedtls_pk_context pk;
+  mbedtls_pk_init(&pk);
+  bool ok = false;
+  if (mbedtls_pk_parse_public_key(&pk, (const unsigned char *)OTA_PUBLIC_KEY,
+                                  strlen(OTA_PUBLIC_KEY) + 1) != 0)
+    logger.error(logOta, "❌ OTA public key missing or invalid");
+  else
+    ok = mbedtls_pk_verify(&pk, MBEDTLS_MD_SHA256, hash, 32, sig, sigLen) == 0;
+  mbedtls_pk_free(&pk);
+  return ok;
+}
+
+// Download, hash and flash the image; true once it is verified and set to boot.
+bool otaDownload() {
+  uint8_t sig[OTA_SIG_MAX];
+  size_t sigLen = otaFetchSignature(sig);
+  if (!sigLen) { logger.error(logOta, "❌ No release signature, update refused"); return false; }
+
+  WiFiClientSecure client;
+  HTTPClient https;
+  int contentLength = otaOpen(https, client, OTA_URL);
+  if (contentLength <= 0) { https.end(); return false; }
+
+  if (!Update.begin(contentLength)) {
+    logger.error(logOta, "❌ Not enough space for OTA");
+    https.end();
+    return false;
+  }
+
+  logger.info(logOta, "⬇️  Downloading %d bytes...", contentLength);
+  WiFiClient *stream = https.getStreamPtr();
+  mbedtls_sha256_context sha;
+  mbedtls_sha256_init(&sha);
+  mbedtls_sha256_starts(&sha, 0);
+
+  size_t written = 0;
+  int lastPct = -1;
+  while (written < (size_t)contentLength) {
+    size_t n = min((size_t)OTA_CHUNK, (size_t)contentLength - written);
+    if (!otaReadFully(stream, otaChunk, n)) {
+      logger.error(logOta, "❌ Download stalled at %u/%d bytes", (unsigned)written, contentLength);
+      break;
+    }
+    mbedtls_sha256_update(&sha, otaChunk, n);
+    if (Update.write(otaChunk, n) != n) {
+      logger.error(logOta, "❌ OTA write error #%u: %s", Update.getError(), Update.errorString());
+      break;
+    }
+    written += n;
+    int pct = written * 10 / contentLength;
+    if (pct != lastPct) { lastPct = pct; logger.info(logOta, "⬇️  %d%%", pct * 10); }
+    delay(OTA_CHUNK_PAUSE_MS);
+  }
+  https.end();
+
+  uint8_t hash[32];
+  mbedtls_sha256_finish(&sha, hash);
+  mbedtls_sha256_free(&sha);
+
+  if (written != (size_t)contentLength) {
+    Update.abort();
+    return false;
+  }
+  if (!otaVerify(hash, sig, sigLen)) {
+    logger.error(logOta, "❌ Signature check failed, image discarded");
+    Update.abort();
+    return false;
+  }
+  // Only now does the new partition become the boot partition
+  if (!Update.end()) {
+    logger.error(logOta, "❌ OTA error #%u: %s", Update.getError(), Update.errorString());
+    return false;
+  }
+  return true;
+}
+
+void otaTask(void *) {
+  logger.info(logOta, "🔁 Starting OTA update from GitHub RAW...");
+  if (otaDownload()) {
+    logger.info(logOta, "✅ Image verified, parking outputs for reboot");
+    safeStateRequested = true;
+    unsigned long t0 = millis();
+    while (!safeStateReached && millis() - t0 < OTA_PARK_WAIT_MS) delay(10);
+    logger.info(logOta, "🎉 OTA successful, rebooting...");
+    delay(500);
+    ESP.restart();
+  }
+  otaRunning = false;
+  vTaskDelete(NULL);
+}
+
+// Start the OTA task unless one is already running.
+void performOTA() {
+  if (otaRunning.exchange(true)) {
+    logger.warn(logOtaStart, "⚠️ OTA already in progress");
+    return;
+  }
+  if (xTaskCreatePinnedToCore(otaTask, "ota", OTA_STACK, nullptr, OTA_PRIORITY,
+                              nullptr, OTA_CORE) != pdPASS) {
+    logger.error(logOtaStart, "❌ Could not start OTA task");
+    otaRunning = false;
+  }
+}
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include "Hal.h"
+
+// Set to 0 to compile every probe out
+#ifndef PERF_ENABLED
+#define PERF_ENABLED    1
+#endif
+
+#define PERF_BUCKETS   24   // log2 µs buckets, the last one catches >= 4 s
+#define PERF_MAX_STATS 24
+
+// ---------- Hot-path instrumentation ----------
+// Each stage times itself with the CPU cycle counter and keeps a log2
+// histogram of run times, so p99 and max come out without storing
+// samples. Scheduled stages also record how late they started and count
+// a missed deadline when they start a full period late. Stats written
+// on the network core are read without locking; a torn read only skews
+// one report line.
+
+struct PerfHist {
+  uint32_t bins[PERF_BUCKETS];   // bin i holds [2^(i-1), 2^i) µs, bin 0 holds 0
+
+  void add(uint32_t us) {
+    uint8_t i = us ? 32 - __builtin_clz(us) : 0;
+    bins[i < PERF_BUCKETS ? i : PERF_BUCKETS - 1]++;
+  }
+
+  // Upper edge of the bin holding the pct-th percentile of n samples
+  uint32_t percentile(uint32_t n, uint8_t pct) const {
+    uint32_t want = (uint32_t)(((uint64_t)n * pct + 99) / 100), seen = 0;
+    for (uint8_t i = 0; i < PERF_BUCKETS; i++) {
+      seen += bins[i];
+      if (seen >= want) return 1UL << i;
+    }
+    return 1UL << (PERF_BUCKETS - 1);
+  }
+};
+
+struct PerfStat {
+  const char *name;
+  bool        scheduled;     // has a deadline (scheduler task)
+  uint32_t    runs, missed;
+  uint32_t    maxUs;
+  uint64_t    totalUs;
+  PerfHist    exec, late;
+
+  void record(uint32_t cycles) {
+    uint32_t us = cycles / halCyclesPerUs();
+    runs++;
+    totalUs += us;
+    if (us > maxUs) maxUs = us;
+    exec.add(us);
+  }
+
+  void recordLate(uint32_t lateUs, uint32_t periodUs) {
+    late.add(lateUs);
+    if (lateUs >= periodUs) missed++;
+  }
+
+  // p99 from the histogram, never above the true maximum
+  uint32_t p99() const {
+    uint32_t edge = exec.percentile(runs, 99);
+    return edge < maxUs ? edge : maxUs;
+  }
+};
+
+class PerfRegistry {
+public:
+  void add(PerfStat &s, const char *name, bool scheduled = false) {
+    s.name = name;
+    s.scheduled = scheduled;
+    clear(s);
+    if (count < PERF_MAX_STATS) stats[count++] = &s;
+  }
+
+  void reset() {
+    for (uint8_t i = 0; i < count; i++) clear(*stats[i]);
+  }
+
+  uint8_t size() const { return count; }
+  const PerfStat &stat(uint8_t i) const { return *stats[i]; }
+
+private:
+  PerfStat *stats[PERF_MAX_STATS];
+  uint8_t   count = 0;
+
+  static void clear(PerfStat &s) {
+    s.runs = s.missed = s.maxUs = 0;
+    s.totalUs = 0;
+    memset(&s.exec, 0, sizeof(s.exec));
+    memset(&s.late, 0, sizeof(s.late));
+  }
+};
+
+extern PerfRegistry perf;
+
+// Times the rest of the enclosing block into a PerfStat
+class PerfScope {
+public:
+  explicit PerfScope(PerfStat &s) : stat(s), start(halCycles()) {}
+  ~PerfScope() { stat.record(halCycles() - start); }
+private:
+  PerfStat &stat;
+  uint32_t  start;
+};
+
+#if PERF_ENABLED
+#define PERF_SCOPE(stat) PerfScope perfScope_(stat)
+#else
+#define PERF_SCOPE(stat)
+#endif
+
+#endif
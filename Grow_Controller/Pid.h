@@ -0,0 +1,188 @@
+#ifndef PID_H
+#define PID_H
+
+#include "Hal.h"
+
+#define PID_OUT_MAX      1000          // output in ‰ of full heater/exhaust power
+#define PID_DT_MAX_MS    10000         // longer gaps (sensor outage) integrate as this
+#define PID_D_FILTER     2             // derivative smoothing, new sample weighs 1/2^n
+#define PID_WINDOW_MS    1800000UL     // time-proportioning window (30 min)
+
+#define TUNE_HYST_MC     300           // relay test switches at setpoint ± this (m°C)
+#define TUNE_CYCLES      3             // oscillations measured after the first
+#define TUNE_TIMEOUT_MS  43200000ULL   // give up after 12 h
+#define TUNE_RELAY_D     (PID_OUT_MAX / 2)   // heater 0-100 % is a ±50 % relay
+
+// Temperatures enter the controllers as integer milli-degrees
+inline int32_t milliC(float c) { return (int32_t)lroundf(c * 1000.0f); }
+
+// ---------- Fixed-point PID ----------
+// Error is in m°C, output in ‰, gains are Q16 ‰ per m°C with integral
+// and derivative time in minutes. The console sets gains in %/°C,
+// %/(°C·min) and %·min/°C; setGains() converts them. Anti-windup
+// clamps the integrator to the output range and stops integrating while
+// the output is pinned in the direction the error pushes. The
+// derivative acts on the measurement, so setpoint edits do not kick it.
+class PidController {
+public:
+  int16_t output = 0;   // last result, ‰
+
+  void setGains(float kp, float ki, float kd) {
+    kpQ = toQ16(kp); kiQ = toQ16(ki); kdQ = toQ16(kd);
+  }
+
+  // Split range: positive output heats, negative vents. A side without
+  // its relay is limited to 0 so the integrator cannot wind into it.
+  void setLimits(int16_t lo, int16_t hi) { outLo = lo; outHi = hi; }
+
+  int16_t update(int32_t sp, int32_t pv, uint64_t nowMs) {
+    uint32_t dtMs = 0;
+    if (primed) dtMs = nowMs - lastMs < PID_DT_MAX_MS ? (uint32_t)(nowMs - lastMs) : PID_DT_MAX_MS;
+
+    int32_t e = sp - pv;
+    int64_t p = (int64_t)kpQ * e;
+    int64_t d = 0;
+    if (dtMs) {
+      int32_t rate = (int32_t)((int64_t)(pv - lastPv) * 60000 / dtMs);   // m°C per minute
+      dRate += (rate - dRate) >> PID_D_FILTER;
+      d = -(int64_t)kdQ * dRate;
+    }
+    lastPv = pv;
+    lastMs = nowMs;
+    primed = true;
+
+    int64_t lo = (int64_t)outLo << 16, hi = (int64_t)outHi << 16;
+    int64_t step = (int64_t)kiQ * e * dtMs / 60000;
+    int64_t out = p + integ + d;
+    if (!((out >= hi && step > 0) || (out <= lo && step < 0))) {
+      integ = clamp(integ + step, lo, hi);
+      out = p + integ + d;
+    }
+    output = (int16_t)(clamp(out, lo, hi) >> 16);
+    return output;
+  }
+
+  void reset() {
+    integ = 0;
+    dRate = 0;
+    output = 0;
+    primed = false;
+  }
+
+private:
+  int32_t  kpQ = 0, kiQ = 0, kdQ = 0;
+  int16_t  outLo = -PID_OUT_MAX, outHi = PID_OUT_MAX;
+  int64_t  integ = 0;             // Q16 ‰
+  int32_t  lastPv = 0, dRate = 0;
+  uint64_t lastMs = 0;
+  bool     primed = false;
+
+  // %/°C is ‰/m°C × 100, so Q16 ‰/m°C = g × 65536 / 100
+  static int32_t toQ16(float g) { return (int32_t)lroundf(g * 655.36f); }
+  static int64_t clamp(int64_t v, int64_t lo, int64_t hi) { return v < lo ? lo : (v > hi ? hi : v); }
+};
+
+// ---------- Time-proportioned relay ----------
+// Turns a duty in ‰ into one on-pulse per PID_WINDOW_MS, so a contactor
+// switches at most once per window. Pulses shorter than the relay's
+// min-run are dropped and off-gaps shorter than it are filled, so the
+// RelayController never has to hold a change back. A pulse in progress
+// follows the duty up or down; once off, the relay waits for the next
+// window unless the duty saturates.
+class TimeProportion {
+public:
+  bool update(uint16_t duty, uint64_t nowMs, uint32_t minRunMs) {
+    uint64_t elapsed = nowMs - windowStart;
+    bool on = started && elapsed < onMs;
+    if (!started || elapsed >= PID_WINDOW_MS || (!on && duty >= PID_OUT_MAX)) {
+      started = true;
+      windowStart = nowMs;
+      elapsed = 0;
+      on = true;
+    }
+    if (on) onMs = pulseMs(duty, minRunMs);
+    return elapsed < onMs;
+  }
+
+  void reset() { started = false; onMs = 0; }
+
+private:
+  uint64_t windowStart = 0;
+  uint32_t onMs = 0;
+  bool     started = false;
+
+  static uint32_t pulseMs(uint16_t duty, uint32_t minRunMs) {
+    uint32_t ms = (uint32_t)((uint64_t)duty * PID_WINDOW_MS / PID_OUT_MAX);
+    if (ms < minRunMs) return 0;
+    if (ms > PID_WINDOW_MS - minRunMs) return PID_WINDOW_MS;
+    return ms;
+  }
+};
+
+// ---------- Relay auto-tune ----------
+// Åström–Hägglund relay test: the heater switches at setpoint ±
+// TUNE_HYST_MC and the room settles into a limit cycle whose period Tu
+// and amplitude a give the ultimate gain Ku = 4d / (πa). Ignoring the
+// hysteresis in a underestimates Ku, which errs on the calm side.
+// Tyreus–Luyben PI rules then give kp = Ku / 3.2 and Ti = 2.2 Tu; they
+// overshoot less than Ziegler–Nichols, which suits a slow room.
+class PidAutotune {
+public:
+  enum State : uint8_t { TUNE_IDLE, TUNE_RUNNING, TUNE_DONE, TUNE_FAILED };
+
+  State   state = TUNE_IDLE;
+  uint8_t cycles = 0;            // oscillations seen, the first is discarded
+  float   kp = 0, ki = 0, kd = 0;   // result in console units
+
+  void start(uint64_t nowMs) {
+    state = TUNE_RUNNING;
+    startedAt = nowMs;
+    cycleStart = 0;
+    cycles = 0;
+    heat = false;
+    periodSum = 0;
+    ampSum = 0;
+  }
+
+  void stop() { state = TUNE_IDLE; }
+  bool running() const { return state == TUNE_RUNNING; }
+
+  // Heater state for this reading
+  bool update(int32_t sp, int32_t pv, uint64_t nowMs) {
+    if (nowMs - startedAt > TUNE_TIMEOUT_MS) { state = TUNE_FAILED; return false; }
+    if (pv > hi) hi = pv;
+    if (pv < lo) lo = pv;
+    if (heat && pv > sp + TUNE_HYST_MC) {
+      heat = false;
+    } else if (!heat && pv < sp - TUNE_HYST_MC) {
+      heat = true;
+      // each heater-on edge closes one oscillation
+      if (cycleStart) {
+        if (cycles++) { periodSum += nowMs - cycleStart; ampSum += hi - lo; }
+        if (cycles > TUNE_CYCLES) finish();
+      }
+      cycleStart = nowMs;
+      hi = lo = pv;
+    }
+    return heat && state == TUNE_RUNNING;
+  }
+
+private:
+  uint64_t startedAt = 0, cycleStart = 0, periodSum = 0;
+  int64_t  ampSum = 0;           // peak-to-peak, m°C
+  int32_t  hi = 0, lo = 0;
+  bool     heat = false;
+
+  void finish() {
+    float a  = ampSum / (2.0f * TUNE_CYCLES);         // m°C
+    float tu = periodSum / (60000.0f * TUNE_CYCLES);  // minutes
+    if (a <= 0 || tu <= 0) { state = TUNE_FAILED; return; }
+    float ku = 4.0f * TUNE_RELAY_D / ((float)M_PI * a) * 100.0f;   // ‰/m°C to %/°C
+    kp = ku / 3.2f;
+    ki = kp / (2.2f * tu);
+    kd = 0;
+    state = TUNE_DONE;
+  }
+};
+
+#endif
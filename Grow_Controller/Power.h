@@ -0,0 +1,132 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <atomic>
+#include "Hal.h"
+#include "Rooms.h"
+#include "Log.h"
+
+#ifndef POWER_SAVE
+#define POWER_SAVE  false   // true: light-sleep between deadlines (solar/battery sites)
+#endif
+
+#define POWER_MAX_MHZ        240
+#define POWER_MIN_MHZ         80     // DFS floor while nothing needs full speed
+#define POWER_UART_EDGES       3     // RX edges that wake the chip (those bytes are lost)
+#define POWER_MAX_TASKS        8
+
+// Polling periods in power-save mode; each bounds a latency, not a deadline
+#define POWER_CONSOLE_MS     500     // queued remote commands; serial input wakes it at once
+#define POWER_LOG_DRAIN_MS   250     // log lines reach the UART this late
+#define POWER_NET_TICK_MS    250
+#define POWER_WEB_TICK_MS    100
+#define POWER_MQTT_TICK_MS   250
+
+// ---------- Power management ----------
+// The scheduler already sleeps until its earliest task deadline (sensor
+// sample, flood check, light edge on the timer wheel); with automatic
+// light-sleep the chip sleeps through those gaps instead of idling at
+// full clock. What kept it awake were the short polling loops (console,
+// log drain, web, MQTT, network at 20-50 ms); power-save mode stretches
+// them to the POWER_*_MS latencies and lets serial input wake the
+// console directly. Relay pins keep their level through sleep, WiFi
+// stays associated in modem sleep, and control periods do not change.
+// The ADC DMA driver holds the clock up and would block sleep, so soil
+// probes switch to one-shot reads at the same sample rate.
+//
+// Time asleep is an estimate: each task reports when it blocks and
+// wakes, and the chip can only sleep while every task is blocked, so
+// 100 % minus the sum of busy time is a lower bound on sleep (tasks on
+// the two cores overlap). Time inside select() or a Telegram long poll
+// counts as blocked, so socket and TLS work is not included.
+
+// One task's busy time and wakeups; only its own task writes them
+struct PowerTask {
+  const char           *name = nullptr;
+  std::atomic<uint32_t> busyMs{0};
+  std::atomic<uint32_t> wakes{0};
+  uint32_t              fracUs = 0;
+  uint64_t              wokeUs = 0;
+
+  void awake() { wokeUs = halMicros64(); }
+
+  void asleep() {
+    uint64_t us = halMicros64() - wokeUs + fracUs;
+    busyMs.fetch_add((uint32_t)(us / 1000), std::memory_order_relaxed);
+    fracUs = us % 1000;
+    wakes.fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+class PowerManager {
+public:
+  bool     enabled = false;
+  bool     lightSleep = false;   // esp_pm accepted the configuration
+  bool     uartWake = false;
+  uint64_t sinceUs = 0;          // start of the reporting window
+
+  void add(PowerTask &t, const char *name) {
+    t.name = name;
+    t.awake();
+    if (count < POWER_MAX_TASKS) tasks[count++] = &t;
+  }
+
+  void begin(bool enable) {
+    logger.add(logSrc);
+    enabled = enable;
+    sinceUs = halMicros64();
+    if (!enabled) return;
+    for (const RoomDef &d : ROOM_TABLE)
+      for (int8_t pin : d.relayPins) if (pin != NO_PIN) halSleepKeepPin(pin);
+    lightSleep = halPowerSave(POWER_MAX_MHZ, POWER_MIN_MHZ);
+    uartWake = halSerialWake(POWER_UART_EDGES, onSerial);
+    if (lightSleep)
+      logger.info(logSrc, "✅ Power save: light-sleep, %u-%u MHz%s", POWER_MIN_MHZ, POWER_MAX_MHZ,
+                  uartWake ? ", serial wakes" : "");
+    else
+      logger.warn(logSrc, "⚠️ Light-sleep not supported by this core build, slow polling only");
+  }
+
+  // From the control task: its sleep is the one serial input cuts short
+  void bindWaker() { waker = halCurrentTask(); }
+
+  // Block a task for ms, accounted as asleep
+  void idle(PowerTask &t, uint32_t ms) {
+    t.asleep();
+    if (ms) halWaitWake(ms);
+    t.awake();
+  }
+
+  // True once after serial input arrived
+  bool takeSerialWake() { return serialWake.exchange(false); }
+
+  // Periods that depend on the mode
+  uint32_t period(uint32_t normalMs, uint32_t saveMs) const { return enabled ? saveMs : normalMs; }
+
+  void reset() {
+    for (uint8_t i = 0; i < count; i++) { tasks[i]->busyMs = 0; tasks[i]->wakes = 0; }
+    sinceUs = halMicros64();
+  }
+
+  uint8_t taskCount() const { return count; }
+  const PowerTask &task(uint8_t i) const { return *tasks[i]; }
+  double seconds() const { return (halMicros64() - sinceUs) / 1e6; }
+
+private:
+  PowerTask           *tasks[POWER_MAX_TASKS];
+  uint8_t              count = 0;
+  std::atomic<HalTask> waker{nullptr};
+  std::atomic<bool>    serialWake{false};
+  LogSource            logSrc{"power"};
+
+  static void onSerial();
+};
+
+extern PowerManager power;
+
+inline void PowerManager::onSerial() {
+  power.serialWake = true;
+  halWakeTask(power.waker);
+}
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef RESUMESTATE_H
+#define RESUMESTATE_H
+
+#include "Rooms.h"
+#include "ConfigStore.h"
+#include "Log.h"
+
+// ---------- Reboot-resilient control state ----------
+// The light phase, flood rest timers and relay min-run ages are copied
+// into RTC memory every second, which survives software, OTA, watchdog
+// and brownout resets. Boot takes them back with the downtime measured
+// on the RTC-backed system clock, so the schedule carries on where it
+// stopped. An NVS checkpoint covers power loss; the outage length is
+// unknown then, so the schedule resumes from the checkpoint as if no
+// time had passed.
+
+#define RESUME_MAGIC           0x524D5347UL   // "GSMR"
+#define RESUME_VERSION         3              // 2: zones store time until ready, 3: humidity relays
+#define RESUME_SAVE_MS         1000           // RTC snapshot period
+#define RESUME_CHECKPOINT_MS   900000UL       // NVS checkpoint period (15 min)
+#define RESUME_MAX_GAP_MS      3600000UL      // a longer measured gap is not trusted
+#define RESUME_NS              "resume"
+#define RESUME_KEY             "state"
+
+struct ResumeImage {
+  uint32_t     magic;
+  uint16_t     version;
+  uint8_t      roomCount;
+  uint8_t      roomSize;
+  uint64_t     savedAtUs;                  // halRtcMicros() at the snapshot
+  RoomSnapshot rooms[MAX_ROOMS];
+  uint32_t     crc;                        // CRC-32 of everything above
+};
+
+extern ResumeImage resumeRtc;   // RTC_NOINIT_ATTR, defined in the sketch
+
+class ResumeStore {
+public:
+  enum Source { RESUME_NONE, RESUME_RTC, RESUME_NVS };
+
+  // Boot: take the RTC image if it is intact, else the NVS checkpoint.
+  Source restore() {
+    logger.add(logSrc);
+    Source from = RESUME_NONE;
+    uint32_t gapMs = 0;
+    bool trusted = false, stepped = false;   // gapMs was measured; the clock went backwards
+    ResumeImage img;
+    if (valid(resumeRtc)) {
+      img = resumeRtc;
+      from = RESUME_RTC;
+      uint64_t nowUs = halRtcMicros();
+      stepped = nowUs < img.savedAtUs;
+      trusted = !stepped && nowUs - img.savedAtUs < RESUME_MAX_GAP_MS * 1000ULL;
+      if (trusted) gapMs = (nowUs - img.savedAtUs) / 1000;
+    } else {
+      prefs.begin(RESUME_NS, true);
+      size_t len = prefs.getBytes(RESUME_KEY, &img, sizeof(img));
+      prefs.end();
+      if (len == sizeof(img) && valid(img)) from = RESUME_NVS;
+    }
+
+    if (from == RESUME_NONE) {
+      logger.info(logSrc, "No saved control state, starting fresh");
+      return from;
+    }
+    for (uint8_t i = 0; i < ROOM_COUNT; i++) rooms[i]->restoreState(img.rooms[i], gapMs);
+    if (from == RESUME_RTC && trusted)
+      logger.info(logSrc, "✅ Resumed from RTC memory, %lu ms down", (unsigned long)gapMs);
+    else if (from == RESUME_RTC)
+      logger.warn(logSrc, "⚠️ Resumed from RTC memory, downtime unknown (%s)",
+                  stepped ? "clock stepped back" : "gap too long to trust");
+    else logger.warn(logSrc, "⚠️ Resumed from the NVS checkpoint, downtime unknown");
+    return from;
+  }
+
+  // Snapshot into RTC memory; cheap enough to run every second.
+  void save() {
+    ResumeImage &img = resumeRtc;
+    img.magic     = RESUME_MAGIC;
+    img.version   = RESUME_VERSION;
+    img.roomCount = ROOM_COUNT;
+    img.roomSize  = sizeof(RoomSnapshot);
+    img.savedAtUs = halRtcMicros();
+    memset(img.rooms, 0, sizeof(img.rooms));
+    for (uint8_t i = 0; i < ROOM_COUNT; i++) rooms[i]->saveState(img.rooms[i]);
+    img.crc = crc32((const uint8_t *)&img, offsetof(ResumeImage, crc));
+  }
+
+  // Copy the current snapshot to flash.
+  void checkpoint() {
+    save();
+    prefs.begin(RESUME_NS, false);
+    bool ok = prefs.putBytes(RESUME_KEY, &resumeRtc, sizeof(resumeRtc)) == sizeof(resumeRtc);
+    prefs.end();
+    if (ok) checkpoints++;
+    else logger.error(logSrc, "❌ Control state checkpoint failed");
+    lastCheckpoint = millis();
+  }
+
+  // Scheduler task
+  void poll() {
+    if (millis() - lastCheckpoint >= RESUME_CHECKPOINT_MS) checkpoint();
+    else save();
+  }
+
+  uint32_t checkpoints = 0;
+
+private:
+  LogSource     logSrc{"resume"};
+  unsigned long lastCheckpoint = 0;
+
+  static bool valid(const ResumeImage &img) {
+    return img.magic == RESUME_MAGIC && img.version == RESUME_VERSION &&
+           img.roomCount == ROOM_COUNT && img.roomSize == sizeof(RoomSnapshot) &&
+           img.crc == crc32((const uint8_t *)&img, offsetof(ResumeImage, crc));
+  }
+};
+
+extern ResumeStore resumeStore;
+
+#endif
@@ -1,110 +1,147 @@
-#ifndef ROOMBASE_H
-#define ROOMBASE_H
-
-#include "Config.h"
-
-// ---------- RoomConfig structure ----------
-struct RoomConfig {
-  String name;
-  float idealTemp;
-  float idealHumidity;
-  int   idealSoil;
-  float tempThreshold;
-  float humidityThreshold;
-  int   soilThreshold;
-  unsigned long lightOnDuration;
-  unsigned long lightOffDuration;
-};
-
-// ---------- Relay Controller (hysteresis + min-run) ----------
-class RelayController {
-public:
-  struct RelayState {
-    bool state = false;
-    unsigned long lastChange = 0;
-  };
-
-  int exhaustPin, heaterPin, waterPin, lightPin, intakePin;
-  unsigned long minRunTime = DEFAULT_MIN_RUN_TIME_MS;
-
-  RelayState exhaustState, heaterState, waterState, lightState, intakeState;
-
-  RelayController(int ex, int ht, int wt, int lt, int in)
-    : exhaustPin(ex), heaterPin(ht), waterPin(wt), lightPin(lt), intakePin(in) {}
-
-  void begin() {
-    pinMode(exhaustPin, OUTPUT);
-    pinMode(heaterPin, OUTPUT);
-    pinMode(waterPin, OUTPUT);
-    pinMode(lightPin, OUTPUT);
-    pinMode(intakePin, OUTPUT);
-    allOff();
-  }
-
-  void allOff() {
-    setRelay(exhaustPin, exhaustState, false);
-    setRelay(heaterPin,  heaterState,  false);
-    setRelay(waterPin,   waterState,   false);
-    setRelay(lightPin,   lightState,   false);
-    setRelay(intakePin,  intakeState,  false);
-  }
-
-  void exhaust(bool s) { setRelay(exhaustPin, exhaustState, s); }
-  void heater (bool s) { setRelay(heaterPin,  heaterState,  s); }
-  void water  (bool s) { setRelay(waterPin,   waterState,   s); }
-  void light  (bool s) { setRelay(lightPin,   lightState,   s); }
-  void intake (bool s) { setRelay(intakePin,  intakeState,  s); }
-
-  bool getState(String name) {
-    if (name == "exhaust") return exhaustState.state;
-    if (name == "heater")  return heaterState.state;
-    if (name == "water")   return waterState.state;
-    if (name == "light")   return lightState.state;
-    if (name == "intake")  return intakeState.state;
-    return false;
-  }
-
-private:
-  void setRelay(int pin, RelayState &r, bool desiredState) {
-    unsigned long now = millis();
-    if (desiredState != r.state) {
-      if (now - r.lastChange >= minRunTime) {
-        r.state = desiredState;
-        r.lastChange = now;
-        digitalWrite(pin, r.state ? HIGH : LOW);
-      }
-    }
-  }
-};
-
-// ---------- Soil average helper ----------
-inline float readSoilAverage(int* pins, int count) {
-  float total = 0;
-  for (int i = 0; i < count; i++) total += analogRead(pins[i]);
-  return total / count;
-}
-
-// ---------- NVS config I/O ----------
-inline void loadConfig(RoomConfig &cfg, const char* ns) {
-  prefs.begin(ns, true);
-  cfg.idealTemp       = prefs.getFloat("temp", cfg.idealTemp);
-  cfg.idealHumidity   = prefs.getFloat("hum",  cfg.idealHumidity);
-  cfg.idealSoil       = prefs.getInt  ("soil", cfg.idealSoil);
-  cfg.tempThreshold   = prefs.getFloat("tTh",  cfg.tempThreshold);
-  cfg.humidityThreshold = prefs.getFloat("hTh", cfg.humidityThreshold);
-  cfg.soilThreshold   = prefs.getInt  ("sTh",  cfg.soilThreshold);
-  prefs.end();
-}
-
-inline void saveConfig(const RoomConfig &cfg, const char* ns) {
-  prefs.begin(ns, false);
-  prefs.putFloat("temp", cfg.idealTemp);
-  prefs.putFloat("hum",  cfg.idealHumidity);
-  prefs.putInt  ("soil", cfg.idealSoil);
-  prefs.putFloat("tTh",  cfg.tempThreshold);
-  prefs.putFloat("hTh",  cfg.humidityThreshold);
-  prefs.putInt  ("sTh",  cfg.soilThreshold);
-  prefs.end();
-}
-
-#endif
+#ifndef ROOMBASE_H
+#define ROOMBASE_H
+
+#include "Config.h"
+#include "Hal.h"
+#include "SoilSensors.h"
+#include "FloodTimer.h"
+#include <initializer_list>
+
+// ---------- RoomConfig structure ----------
+enum ClimateMode { CLIMATE_HYSTERESIS = 0, CLIMATE_PID = 1 };
+enum HumidityMode { HUMIDITY_OFF = 0, HUMIDITY_RH = 1, HUMIDITY_VPD = 2 };
+
+struct RoomConfig {
+  String name;
+  float idealTemp;
+  float idealHumidity;
+  float idealSoil;                 // moisture %
+  float tempThreshold;
+  float humidityThreshold;
+  float soilThreshold;             // % points
+  unsigned long lightOnDuration;
+  unsigned long lightOffDuration;
+  unsigned long lightStart;        // ms after local midnight a cycle begins (wall clock only)
+  int   climateMode;               // ClimateMode
+  float pidKp, pidKi, pidKd;       // %/°C, %/(°C·min), %·min/°C
+  int   humidityMode;              // HumidityMode
+  float vpdTarget, vpdThreshold;   // kPa
+};
+
+// ---------- Relay Controller (min-run + batched GPIO) ----------
+// Channels are indexed by the Relay enum (or any channel number up to
+// MAX_CHANNELS for expanded banks). set() only records the wanted state;
+// commit() applies every change the min-run rule allows in one pair of
+// GPIO set/clear register writes, so several relays switch together.
+enum Relay : uint8_t {
+  RELAY_EXHAUST,
+  RELAY_HEATER,
+  RELAY_WATER,
+  RELAY_LIGHT,
+  RELAY_INTAKE,
+  RELAY_HUMIDIFIER,
+  RELAY_DEHUMIDIFIER,
+  ROOM_RELAY_COUNT
+};
+
+constexpr const char *RELAY_NAMES[ROOM_RELAY_COUNT] = {
+  "exhaust", "heater", "water", "light", "intake", "humidifier", "dehumidifier",
+};
+
+class RelayController {
+public:
+  static const uint8_t MAX_CHANNELS = 32;
+
+  unsigned long minRunTime = DEFAULT_MIN_RUN_TIME_MS;   // default for every channel
+
+  // Pins in channel order, e.g. {exhaust, heater, water, light, intake};
+  // a negative pin leaves that channel unwired.
+  RelayController(std::initializer_list<int> pinList) {
+    for (int p : pinList) if (count < MAX_CHANNELS) pins[count++] = p;
+  }
+
+  RelayController(const int8_t *pinList, uint8_t n) {
+    for (uint8_t i = 0; i < n && count < MAX_CHANNELS; i++) pins[count++] = pinList[i];
+  }
+
+  void begin() {
+    unsigned long now = millis();
+    for (uint8_t ch = 0; ch < count; ch++) {
+      if (pins[ch] >= 0) pinMode(pins[ch], OUTPUT);
+      minRun[ch] = minRunTime;
+      lastChange[ch] = now - minRun[ch];   // first switch is never held back
+    }
+    allOff(true);
+  }
+
+  void set(uint8_t ch, bool on) {
+    if (ch >= count) return;
+    if (on) wanted |= chBit(ch); else wanted &= ~chBit(ch);
+  }
+
+  // Apply pending changes; channels still inside min-run stay pending.
+  void commit(bool force = false) {
+    uint32_t diff = wanted ^ state;
+    if (!diff) return;
+    unsigned long now = millis();
+    uint64_t setPins = 0, clearPins = 0;
+    for (uint8_t ch = 0; ch < count; ch++) {
+      uint32_t b = chBit(ch);
+      if (!(diff & b)) continue;
+      if (!force && now - lastChange[ch] < minRun[ch]) continue;
+      lastChange[ch] = now;
+      state ^= b;
+      if (wanted & b) setPins |= pinMask(ch);
+      else            clearPins |= pinMask(ch);
+    }
+    gpioWriteMasks(setPins, clearPins);
+  }
+
+  // Drop a channel immediately, ignoring min-run (e.g. after a flood timer
+  // has already cut its pin from the timer task).
+  void forceOff(uint8_t ch) {
+    if (ch >= count) return;
+    wanted &= ~chBit(ch);
+    if (!(state & chBit(ch))) return;
+    state &= ~chBit(ch);
+    lastChange[ch] = millis();
+    gpioWriteMasks(0, pinMask(ch));
+  }
+
+  void allOff(bool force = false) {
+    wanted = 0;
+    commit(force);
+  }
+
+  bool get(uint8_t ch) const     { return state & chBit(ch); }
+  bool pending(uint8_t ch) const { return (state ^ wanted) & chBit(ch); }
+  uint32_t states() const        { return state; }
+  int  pin(uint8_t ch) const     { return ch < count ? pins[ch] : -1; }
+  uint8_t size() const           { return count; }
+
+  void setMinRun(uint8_t ch, unsigned long ms) { if (ch < count) minRun[ch] = ms; }
+  unsigned long minRunOf(uint8_t ch) const     { return ch < count ? minRun[ch] : 0; }
+
+  // Min-run bookkeeping as an age, so it can be carried across a reboot
+  unsigned long sinceChange(uint8_t ch) const { return ch < count ? millis() - lastChange[ch] : 0; }
+  void restoreSinceChange(uint8_t ch, unsigned long ms) { if (ch < count) lastChange[ch] = millis() - ms; }
+
+private:
+  int           pins[MAX_CHANNELS];
+  unsigned long lastChange[MAX_CHANNELS];
+  unsigned long minRun[MAX_CHANNELS];
+  uint8_t       count  = 0;
+  uint32_t      state  = 0;   // what the pins are driving
+  uint32_t      wanted = 0;   // what the rooms asked for
+
+  static uint32_t chBit(uint8_t ch) { return 1UL << ch; }
+  uint64_t pinMask(uint8_t ch) const { return pins[ch] >= 0 ? 1ULL << pins[ch] : 0; }
+};
+
+// ---------- Soil average helper ----------
+// Filtered values from the acquisition task; NAN if every probe is faulted.
+inline float readSoilAverage(int* pins, int count) {
+  return soilSensors.average(pins, count);
+}
+
+#endif
@@ -0,0 +1,532 @@
+#ifndef ROOMCONTROLLER_H
+#define ROOMCONTROLLER_H
+
+#include "RoomBase.h"
+#include "ClimateSensor.h"
+#include "Log.h"
+#include "Link.h"
+#include "TimerWheel.h"
+#include "ConfigStore.h"
+#include "Pid.h"
+#include "Vpd.h"
+#include "Irrigation.h"
+
+// ---------- Room and zone definitions ----------
+// A room is one climate (heater, exhaust, light) plus any number of flood
+// zones. A zone is a pump or solenoid relay and the slice of the room's
+// soil probes that decides when it opens. Rooms are declared as rows of
+// ROOM_TABLE in Rooms.h.
+
+#define NO_PIN  -1   // relay channel not fitted in this room
+
+struct ZoneDef {
+  const char *name;         // console name, e.g. "mother"
+  const char *tag;          // log prefix, e.g. "MOTHER"
+  uint8_t     relay;        // Relay channel that opens the zone
+  uint8_t     firstProbe;   // probes [firstProbe, firstProbe + probeCount)
+  uint8_t     probeCount;
+  float       soilOffset;   // % points relative to RoomConfig::idealSoil
+  uint16_t    intervalMin;  // minimum time between floods
+  uint16_t    durationSec;  // flood length
+  uint16_t    currentMa;    // pump or solenoid draw, counted against IRR_SUPPLY_MA
+};
+
+struct RoomDef {
+  const char *name;                         // console and NVS key
+  const char *title;                        // RoomConfig::name
+  int8_t      relayPins[ROOM_RELAY_COUNT];  // Relay enum order, NO_PIN if absent
+  int8_t      soilPins[ROOM_MAX_PROBES];
+  uint8_t     probeCount;
+  ZoneDef     zones[ROOM_MAX_ZONES];
+  uint8_t     zoneCount;
+  float       idealTemp, idealHumidity;
+  float       idealVpd;                     // kPa
+  float       idealSoil;                    // moisture %
+  uint8_t     lightOnHours, lightOffHours;
+};
+
+// Timing state worth keeping across a reboot, stored as ages relative to
+// the moment of the snapshot (see ResumeState.h)
+struct RoomSnapshot {
+  uint32_t lightPhaseMs;                   // position in the light cycle
+  uint32_t zoneReadyInMs[ROOM_MAX_ZONES];  // until each zone may flood again
+  uint32_t relayAgeMs[ROOM_RELAY_COUNT];   // since each channel last switched
+};
+
+// ---------- Room interface ----------
+// What the scheduler tasks, console and telemetry see of any room.
+class Room {
+public:
+  const RoomDef  &def;
+  RoomConfig      cfg;
+  RelayController relays;
+  ClimateGroup    climate;
+  LogSource       logSrc;
+
+  // last climate reading, kept for status output
+  float lastTemp = NAN, lastHum = NAN, lastVpd = NAN;
+  bool  lightState = false;
+  int64_t lightAnchor = 0;   // millis64() of a cycle start; the time base without a wall clock
+  bool  sensorAlarm = false, tempAlarm = false;   // alert raised, waiting to clear
+  int16_t climateOutput = 0;   // PID output in ‰: + heater, - exhaust
+
+  explicit Room(const RoomDef &d) : def(d), relays(d.relayPins, ROOM_RELAY_COUNT), logSrc(d.name) {
+    cfg = {
+      d.title, d.idealTemp, d.idealHumidity, d.idealSoil,
+      DEFAULT_TEMP_THRESHOLD, DEFAULT_HUMIDITY_THRESHOLD, DEFAULT_SOIL_THRESHOLD,
+      d.lightOnHours * 3600000UL, d.lightOffHours * 3600000UL,
+      DEFAULT_LIGHT_START_HOUR * 3600000UL,
+      CLIMATE_HYSTERESIS, DEFAULT_PID_KP, DEFAULT_PID_KI, DEFAULT_PID_KD,
+      HUMIDITY_VPD, d.idealVpd, DEFAULT_VPD_THRESHOLD
+    };
+  }
+
+  const char *name() const { return def.name; }
+  uint8_t zoneCount() const { return def.zoneCount; }
+  float zoneTarget(uint8_t z) const {
+    float t = cfg.idealSoil + def.zones[z].soilOffset;
+    return t < 0 ? 0 : t > 100 ? 100 : t;   // the offset may push past the scale
+  }
+
+  // A channel some zone floods through, e.g. veg's intake driving the mother solenoid
+  bool zoneRelay(uint8_t ch) const {
+    for (uint8_t z = 0; z < def.zoneCount; z++) if (def.zones[z].relay == ch) return true;
+    return false;
+  }
+
+  virtual void begin() = 0;
+  virtual void sampleSoil() = 0;
+  virtual void controlEnvironment(float temp, float hum) = 0;
+  virtual void scheduleOnlyClimate() = 0;   // no sensor: heater off, exhaust with the lights
+  virtual void handleLighting() = 0;   // watches the clock, events do the switching
+  virtual void planLighting() = 0;     // set the light for now and arm the next edge
+  virtual void manageWatering() = 0;
+  virtual void printStatus() = 0;
+  virtual void enterSafeState() = 0;   // every output off, floods closed
+  virtual void saveState(RoomSnapshot &s) const = 0;
+  virtual void restoreState(const RoomSnapshot &s, uint32_t gapMs) = 0;   // gapMs: time spent down
+  virtual float zoneSoil(uint8_t z) const = 0;
+  virtual bool zoneWatering(uint8_t z) const = 0;
+  virtual bool startAutotune() = 0;   // false if the room has no heater
+  virtual void stopAutotune() = 0;
+  virtual const PidAutotune &autotune() const = 0;
+
+  // Log a line and also push it to the chat as an alert
+  void notify(LogLevel lvl, const char *fmt, ...) __attribute__((format(printf, 3, 4))) {
+    AlertMsg a;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(a.text, sizeof(a.text), fmt, ap);
+    va_end(ap);
+    logger.log(logSrc, lvl, "%s", a.text);
+    alertQueue.push(a);
+  }
+
+  // Edge-triggered sensor alarm; a sensor missing since boot is reported
+  // once its first reading would have gone stale.
+  void checkSensor(bool ok) {
+    if (!ok && !sensorAlarm && millis() >= AHT_STALE_MS) {
+      sensorAlarm = true;
+      notify(LOG_WARN, "⚠️ %s sensor failed, climate on schedule only", cfg.name.c_str());
+    } else if (ok && sensorAlarm) {
+      sensorAlarm = false;
+      notify(LOG_INFO, "✅ %s sensor reading again", cfg.name.c_str());
+    }
+  }
+};
+
+// ---------- Room controller ----------
+// One implementation for every room. Traits supplies the definition and
+// its sizes as constants:
+//   static constexpr const RoomDef &def();
+//   static constexpr uint8_t PROBES, ZONES;
+//   static constexpr bool has(uint8_t relay);
+// Per-zone state is sized by Traits::ZONES, and stages for relays a room
+// does not have compile away.
+template <typename Traits>
+class RoomController : public Room {
+public:
+  RoomController() : Room(Traits::def()) {
+    for (uint8_t i = 0; i < Traits::PROBES; i++) soilPins[i] = Traits::def().soilPins[i];
+  }
+
+  void begin() override {
+    relays.begin();
+    intakeFan = Traits::has(RELAY_INTAKE) && !zoneRelay(RELAY_INTAKE);
+    logger.add(logSrc);
+    lightEvent.bind(onLightEvent, this, def.name);
+    for (uint8_t z = 0; z < Traits::ZONES; z++) {
+      ZoneState &zs = zones[z];
+      zs.timer.begin(def.zones[z].tag);
+      zs.ready.bind(onZoneReady, &zs, def.zones[z].name);
+      zs.resting = true;   // first flood no sooner than one interval after boot
+      timerWheel.arm(zs.ready, millis64() + def.zones[z].intervalMin * 60000ULL, "flood ready");
+    }
+    for (uint8_t i = 0; i < Traits::PROBES; i++) soilSensors.add(soilPins[i]);
+  }
+
+  // ---- Scheduled stages ----
+  void sampleSoil() override {
+    for (uint8_t z = 0; z < Traits::ZONES; z++)
+      zones[z].soil = readSoilAverage(soilPins + def.zones[z].firstProbe, def.zones[z].probeCount);
+  }
+
+  void controlEnvironment(float temp, float hum) override {
+    lastTemp = temp; lastHum = hum;
+    checkTempBand(temp);
+    if (cfg.climateMode != activeMode) {   // switched from the console
+      activeMode = cfg.climateMode;
+      resetPid();
+    }
+    if (tune.running()) autotuneStep(temp);
+    else if (activeMode == CLIMATE_PID) pidStep(temp);
+    else hysteresisStep(temp);
+    humidityStep(temp, hum);
+    relays.commit();   // climate relays switch together
+  }
+
+  // Without a reading the heater is the risk, so it stays off; the exhaust
+  // runs while the lights (the main heat source) are on.
+  void scheduleOnlyClimate() override {
+    if (tune.running()) {
+      tune.stop();
+      notify(LOG_WARN, "⚠️ %s auto-tune stopped, sensor lost", cfg.name.c_str());
+    }
+    resetPid();
+    humidDemand = 0;
+    ventForHumidity = false;
+    if (Traits::has(RELAY_HEATER)) { relays.set(RELAY_HEATER, false); heaterOn = false; }
+    if (Traits::has(RELAY_EXHAUST)) { relays.set(RELAY_EXHAUST, lightState); exhaustOn = lightState; }
+    if (intakeFan) relays.set(RELAY_INTAKE, lightState);
+    if (Traits::has(RELAY_HUMIDIFIER)) relays.set(RELAY_HUMIDIFIER, false);
+    if (Traits::has(RELAY_DEHUMIDIFIER)) relays.set(RELAY_DEHUMIDIFIER, false);
+    relays.commit();
+  }
+
+  bool startAutotune() override {
+    if (!Traits::has(RELAY_HEATER)) return false;
+    tune.start(millis64());
+    notify(LOG_INFO, "🎛️ %s auto-tune started around %.1f°C", cfg.name.c_str(), cfg.idealTemp);
+    return true;
+  }
+
+  void stopAutotune() override {
+    if (!tune.running()) return;
+    tune.stop();
+    resetPid();
+    logger.info(logSrc, "%s auto-tune cancelled", cfg.name.c_str());
+  }
+
+  const PidAutotune &autotune() const override { return tune; }
+
+  // Light edges come from the timer wheel; this 1 s check only re-plans
+  // when the time base changes (clock set, lost or stepped).
+  void handleLighting() override {
+    if (!Traits::has(RELAY_LIGHT)) return;
+    uint64_t wall;
+    bool timed = halWallMs(wall);
+    int64_t offset = timed ? (int64_t)(wall - millis64()) : 0;
+    int64_t slew = offset - wallOffset;
+    if (!lightEvent.armed || timed != wallTimed || (timed && (slew > LIGHT_CLOCK_SLEW_MS || slew < -LIGHT_CLOCK_SLEW_MS)))
+      planLighting();
+  }
+
+  // With a wall clock each cycle starts at lightStart local time, so the
+  // photoperiod stays on the real day; without one it runs from the
+  // anchor, which is kept in step whenever the clock is available.
+  void planLighting() override {
+    if (!Traits::has(RELAY_LIGHT)) return;
+    uint64_t now = millis64();
+    uint64_t on = cfg.lightOnDuration, cycle = on + cfg.lightOffDuration;
+    if (!cycle) {
+      timerWheel.cancel(lightEvent);
+      setLight(false);
+      return;
+    }
+    uint64_t wall, phase;
+    wallTimed = halWallMs(wall);
+    if (wallTimed) {
+      wallOffset = (int64_t)(wall - now);
+      phase = (wall + cycle - cfg.lightStart % cycle) % cycle;
+      lightAnchor = (int64_t)now - (int64_t)phase;
+    } else {
+      phase = phaseAt(now, cycle);
+    }
+    bool shouldBeOn = phase < on;
+    setLight(shouldBeOn);
+    timerWheel.arm(lightEvent, now + (shouldBeOn ? on - phase : cycle - phase),
+                   shouldBeOn ? "light off" : "light on");
+  }
+
+  void manageWatering() override {
+    for (uint8_t z = 0; z < Traits::ZONES; z++) manageZone(z);
+    relays.commit();
+  }
+
+  void printStatus() override {
+    logger.info(logSrc, "---- %s ----", cfg.name.c_str());
+    logger.info(logSrc, "Temp: %.1f°C  Hum: %.1f%%  VPD: %.2f kPa  Light: %s",
+      lastTemp, lastHum, lastVpd, lightState ? "ON" : "OFF");
+    for (uint8_t z = 0; z < Traits::ZONES; z++)
+      logger.info(logSrc, "Zone %-8s soil %.1f%% / %.1f%%  %s", def.zones[z].name,
+        zones[z].soil, zoneTarget(z), relays.get(def.zones[z].relay) ? "ON" : "OFF");
+    logger.info(logSrc, "------------------");
+  }
+
+  void enterSafeState() override {
+    for (uint8_t z = 0; z < Traits::ZONES; z++) {
+      if (zones[z].watering) zones[z].timer.stop();
+      zones[z].watering = false;
+      irrigation.cancel(this, z);
+      irrigation.release(this, z);
+    }
+    relays.allOff(true);
+  }
+
+  // A flood cut short by the reboot counts as finished when the snapshot
+  // was taken, so its rest period starts there.
+  void saveState(RoomSnapshot &s) const override {
+    uint64_t now = millis64();
+    uint64_t cycle = cfg.lightOnDuration + cfg.lightOffDuration;
+    s.lightPhaseMs = cycle ? phaseAt(now, cycle) : 0;
+    for (uint8_t z = 0; z < ROOM_MAX_ZONES; z++) {
+      uint64_t in = 0;
+      if (z >= Traits::ZONES) in = 0;
+      else if (zones[z].watering) in = restAfterFlood(z);
+      else if (zones[z].resting && zones[z].ready.dueMs > now) in = zones[z].ready.dueMs - now;
+      s.zoneReadyInMs[z] = (uint32_t)min(in, (uint64_t)UINT32_MAX);
+    }
+    for (uint8_t ch = 0; ch < ROOM_RELAY_COUNT; ch++)
+      s.relayAgeMs[ch] = min(relays.sinceChange(ch), (unsigned long)INT32_MAX);
+  }
+
+  void restoreState(const RoomSnapshot &s, uint32_t gapMs) override {
+    uint64_t now = millis64();
+    uint64_t cycle = cfg.lightOnDuration + cfg.lightOffDuration;
+    if (cycle) lightAnchor = (int64_t)now - (int64_t)((s.lightPhaseMs + (uint64_t)gapMs) % cycle);
+    for (uint8_t z = 0; z < Traits::ZONES; z++) {
+      ZoneState &zs = zones[z];
+      zs.resting = s.zoneReadyInMs[z] > gapMs;
+      if (zs.resting) timerWheel.arm(zs.ready, now + s.zoneReadyInMs[z] - gapMs, "flood ready");
+      else timerWheel.cancel(zs.ready);
+    }
+    for (uint8_t ch = 0; ch < ROOM_RELAY_COUNT; ch++)
+      relays.restoreSinceChange(ch, s.relayAgeMs[ch] + gapMs);
+  }
+
+  float zoneSoil(uint8_t z) const override { return z < Traits::ZONES ? zones[z].soil : NAN; }
+  bool zoneWatering(uint8_t z) const override { return z < Traits::ZONES && zones[z].watering; }
+
+private:
+  struct ZoneState {
+    FloodTimer    timer;
+    WheelEvent    ready;            // ends the rest period
+    uint64_t      floodStart = 0;
+    float         soil = 0;
+    bool          watering = false;
+    bool          resting = true;
+    bool          timed = false;    // the one-shot timer cuts this flood
+  };
+
+  int        soilPins[Traits::PROBES];
+  ZoneState  zones[Traits::ZONES];
+  bool       heaterOn = false, exhaustOn = false;
+  int        activeMode = CLIMATE_HYSTERESIS;
+  int8_t     humidDemand = 0;         // -1 drying, 0 idle, 1 humidifying
+  bool       ventForHumidity = false;
+  bool       intakeFan = false;       // intake wired and not a zone valve
+  PidController  pid;
+  TimeProportion heatDuty, ventDuty;
+  PidAutotune    tune;
+  WheelEvent lightEvent;
+  bool       wallTimed = false;   // the last plan used the wall clock
+  int64_t    wallOffset = 0;      // wall - millis64() at that plan
+
+  static void onLightEvent(void *ctx) { static_cast<RoomController *>(ctx)->planLighting(); }
+  static void onZoneReady(void *ctx) { static_cast<ZoneState *>(ctx)->resting = false; }
+  static bool onFloodGrant(void *ctx, uint8_t z) { return static_cast<RoomController *>(ctx)->startFlood(z); }
+
+  void setLight(bool on) {
+    relays.set(RELAY_LIGHT, on);
+    lightState = on;
+    relays.commit();
+  }
+
+  // Position in the light cycle by the monotonic anchor
+  uint64_t phaseAt(uint64_t now, uint64_t cycle) const {
+    int64_t d = ((int64_t)now - lightAnchor) % (int64_t)cycle;
+    return d < 0 ? d + cycle : d;
+  }
+
+  // Post-water delay then the zone's interval, from the end of a flood
+  uint64_t restAfterFlood(uint8_t z) const {
+    return POST_WATER_DELAY_MIN * 60000ULL + def.zones[z].intervalMin * 60000ULL;
+  }
+
+  // ---- Temperature hysteresis ----
+  void hysteresisStep(float temp) {
+    if (Traits::has(RELAY_HEATER)) {
+      if (!heaterOn && temp < cfg.idealTemp - cfg.tempThreshold) {
+        relays.set(RELAY_HEATER, true); heaterOn = true;
+      } else if (heaterOn && temp > cfg.idealTemp + cfg.tempThreshold) {
+        relays.set(RELAY_HEATER, false); heaterOn = false;
+      }
+    }
+
+    if (Traits::has(RELAY_EXHAUST)) {
+      if (!exhaustOn && temp > cfg.idealTemp + cfg.tempThreshold) {
+        relays.set(RELAY_EXHAUST, true); exhaustOn = true;
+      } else if (exhaustOn && temp < cfg.idealTemp - cfg.tempThreshold) {
+        relays.set(RELAY_EXHAUST, false); exhaustOn = false;
+      }
+    }
+  }
+
+  // ---- PID: one signed output, heater above zero, exhaust below ----
+  void pidStep(float temp) {
+    uint64_t now = millis64();
+    pid.setGains(cfg.pidKp, cfg.pidKi, cfg.pidKd);
+    pid.setLimits(Traits::has(RELAY_EXHAUST) ? -PID_OUT_MAX : 0, Traits::has(RELAY_HEATER) ? PID_OUT_MAX : 0);
+    climateOutput = pid.update(milliC(cfg.idealTemp), milliC(temp), now);
+    if (Traits::has(RELAY_HEATER)) {
+      heaterOn = heatDuty.update(climateOutput > 0 ? climateOutput : 0, now, relays.minRunOf(RELAY_HEATER));
+      relays.set(RELAY_HEATER, heaterOn);
+    }
+    if (Traits::has(RELAY_EXHAUST)) {
+      exhaustOn = ventDuty.update(climateOutput < 0 ? -climateOutput : 0, now, relays.minRunOf(RELAY_EXHAUST));
+      relays.set(RELAY_EXHAUST, exhaustOn);
+    }
+  }
+
+  // ---- Relay test: heater only, exhaust held off ----
+  void autotuneStep(float temp) {
+    heaterOn = tune.update(milliC(cfg.idealTemp), milliC(temp), millis64());
+    relays.set(RELAY_HEATER, heaterOn);
+    if (Traits::has(RELAY_EXHAUST)) { relays.set(RELAY_EXHAUST, false); exhaustOn = false; }
+    if (tune.state == PidAutotune::TUNE_DONE) {
+      cfg.pidKp = tune.kp;
+      cfg.pidKi = tune.ki;
+      cfg.pidKd = tune.kd;
+      cfg.climateMode = activeMode = CLIMATE_PID;
+      resetPid();
+      configStore.touch();
+      notify(LOG_INFO, "🎛️ %s tuned: kp %.1f ki %.3f kd %.1f, PID on",
+             cfg.name.c_str(), tune.kp, tune.ki, tune.kd);
+    } else if (tune.state == PidAutotune::TUNE_FAILED) {
+      resetPid();
+      notify(LOG_WARN, "⚠️ %s auto-tune gave up, no steady oscillation", cfg.name.c_str());
+    }
+  }
+
+  // ---- Humidity: runs after the temperature loop and only adds to it ----
+  // Humidifier and dehumidifier relays act freely. Without a
+  // dehumidifier the room dries by venting (exhaust, plus the intake fan
+  // if it is not a zone valve), but not while the temperature loop heats
+  // or the room is below its band, so the two loops cannot fight over
+  // the exhaust.
+  void humidityStep(float temp, float hum) {
+    int32_t airMc = milliC(temp);
+    int32_t vpd = vpdPa(airMc, airMc + (lightState ? milliC(VPD_LEAF_OFFSET) : 0), lroundf(hum * 10));
+    lastVpd = vpd / 1000.0f;
+
+    // wetness above target and the band, in Pa or ‰ RH
+    int32_t wet = 0, band = 0;
+    if (cfg.humidityMode == HUMIDITY_VPD) {
+      wet = milliC(cfg.vpdTarget) - vpd;
+      band = milliC(cfg.vpdThreshold);
+    } else if (cfg.humidityMode == HUMIDITY_RH) {
+      wet = lroundf((hum - cfg.idealHumidity) * 10);
+      band = lroundf(cfg.humidityThreshold * 10);
+    }
+    if (cfg.humidityMode != HUMIDITY_VPD && cfg.humidityMode != HUMIDITY_RH) humidDemand = 0;
+    else if (wet > band) humidDemand = -1;
+    else if (wet < -band) humidDemand = 1;
+    else if ((humidDemand < 0 && wet <= 0) || (humidDemand > 0 && wet >= 0)) humidDemand = 0;   // back at target
+
+    if (Traits::has(RELAY_HUMIDIFIER)) relays.set(RELAY_HUMIDIFIER, humidDemand > 0);
+    if (Traits::has(RELAY_DEHUMIDIFIER)) relays.set(RELAY_DEHUMIDIFIER, humidDemand < 0);
+
+    // A vent starts only while the temperature loop is not calling for
+    // heat, then runs until the room is dry enough, cools out of its band
+    // or the heater actually comes on.
+    bool heating = activeMode == CLIMATE_PID ? climateOutput > 0 : heaterOn;
+    bool mayVent = humidDemand < 0 && !Traits::has(RELAY_DEHUMIDIFIER) && !tune.running() &&
+                   !heaterOn && temp >= cfg.idealTemp - cfg.tempThreshold;
+    ventForHumidity = mayVent && (ventForHumidity || !heating);
+    if (Traits::has(RELAY_EXHAUST)) relays.set(RELAY_EXHAUST, exhaustOn || ventForHumidity);
+    if (intakeFan) relays.set(RELAY_INTAKE, exhaustOn || ventForHumidity);
+  }
+
+  void resetPid() {
+    pid.reset();
+    heatDuty.reset();
+    ventDuty.reset();
+    climateOutput = 0;
+  }
+
+  // Raise once past the margin, clear once back inside the hysteresis band
+  void checkTempBand(float temp) {
+    float off = fabsf(temp - cfg.idealTemp);
+    if (!tempAlarm && off > cfg.tempThreshold + ALERT_TEMP_MARGIN) {
+      tempAlarm = true;
+      notify(LOG_WARN, "🌡️ %s at %.1f°C, target %.1f ± %.1f", cfg.name.c_str(),
+             temp, cfg.idealTemp, cfg.tempThreshold);
+    } else if (tempAlarm && off <= cfg.tempThreshold) {
+      tempAlarm = false;
+      notify(LOG_INFO, "✅ %s back in band at %.1f°C", cfg.name.c_str(), temp);
+    }
+  }
+
+  // ---- Flood logic ----
+  // A dry zone queues for the shared supply (Irrigation.h) and floods
+  // when granted; it leaves the queue again if it is no longer dry.
+  void manageZone(uint8_t z) {
+    const ZoneDef &zd = def.zones[z];
+    ZoneState &zs = zones[z];
+    uint64_t now = millis64();
+    uint32_t durationMs = zd.durationSec * 1000UL;
+
+    if (!zs.watering) {
+      // in 0.1 % so the supply queue can rank zones finer than whole percent
+      int32_t dryness = isnan(zs.soil) ? 0 : lroundf((zoneTarget(z) - zs.soil) * 10);
+      if (!zs.resting && dryness > lroundf(cfg.soilThreshold * 10)) {
+        FloodRequest r = { onFloodGrant, this, z, zd.name, dryness, durationMs, zd.currentMa,
+                           now, now + IRR_DEADLINE_MIN * 60000ULL };
+        irrigation.submit(r);
+      } else {
+        irrigation.cancel(this, z);
+      }
+    } else {
+      // normally the timer has already cut the output; the backstop covers a dead
+      // timer, and a flood whose timer never armed ends here on time
+      bool timerDone = zs.timer.fired();
+      if (timerDone || now - zs.floodStart >= durationMs + (zs.timed ? FLOOD_BACKSTOP_MS : 0)) {
+        if (!timerDone) zs.timer.stop();
+        relays.forceOff(zd.relay);
+        irrigation.release(this, z);
+        zs.watering = false;
+        zs.resting = true;
+        timerWheel.arm(zs.ready, now + restAfterFlood(z), "flood ready");
+        notify(LOG_INFO, "[%s] ✅ Flood ended after %.3f s (set %lu s), rest period active",
+               zd.tag, zs.timer.lastActualMs / 1000.0, (unsigned long)durationMs / 1000);
+      }
+    }
+  }
+
+  // Called by the irrigation scheduler when the supply is free
+  bool startFlood(uint8_t z) {
+    const ZoneDef &zd = def.zones[z];
+    ZoneState &zs = zones[z];
+    relays.set(zd.relay, true);
+    relays.commit();
+    if (!relays.get(zd.relay)) { relays.set(zd.relay, false); return false; }   // held by min-run, retry later
+    zs.timed = zs.timer.start(relays.pin(zd.relay), zd.durationSec * 1000UL);
+    if (!zs.timed) notify(LOG_WARN, "[%s] ⚠️ Flood timer did not arm, the control loop ends this flood", zd.tag);
+    zs.watering = true;
+    zs.floodStart = millis64();
+    notify(LOG_INFO, "[%s] 🌊 Flood started", zd.tag);
+    return true;
+  }
+};
+
+#endif
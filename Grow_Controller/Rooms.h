@@ -0,0 +1,58 @@
+#ifndef ROOMS_H
+#define ROOMS_H
+
+#include "RoomController.h"
+
+// ---------- Room table ----------
+// One row per room. Relay pins are in Relay enum order (exhaust, heater,
+// water, light, intake, humidifier, dehumidifier); a channel a zone uses
+// only floods that zone. Soil targets are moisture % (see SoilSensors.h);
+// zone targets are offsets from the room's idealSoil, so `set <room> soil`
+// moves every zone together. Shared
+// POST_WATER_DELAY_MIN from Config.h. mA is the zone's draw on the
+// shared flood supply (IRR_SUPPLY_MA).
+constexpr RoomDef ROOM_TABLE[] = {
+  { "veg", "Veg Room",
+    { 5, 18, 19, 21, 22, NO_PIN, NO_PIN },
+    { 34, 35, 32, 33, 27 }, 5,
+    { //  name      tag       relay         probes  offset  every   for   mA
+      { "veg",    "VEG",    RELAY_WATER,  0, 4,      0,    120,   45,  1800 },
+      { "mother", "MOTHER", RELAY_INTAKE, 4, 1,      4,    240,   30,   400 },   // intake = mother solenoid
+    }, 2,
+    26.0, 60.0, 1.0, 40.0, 18, 6 },
+
+  { "flower", "Flower Room",
+    { 23, 25, 26, 27, 14, NO_PIN, NO_PIN },
+    { 36, 39, 25, 26 }, 4,
+    { //  name      tag       relay         probes  offset  every   for   mA
+      { "flower", "FLOWER", RELAY_WATER,  0, 4,      0,    180,   60,  1800 },
+    }, 1,
+    24.0, 55.0, 1.2, 48.0, 12, 12 },
+};
+
+constexpr uint8_t ROOM_COUNT = sizeof(ROOM_TABLE) / sizeof(ROOM_TABLE[0]);
+static_assert(ROOM_COUNT <= MAX_ROOMS, "raise MAX_ROOMS in Config.h");
+
+// Traits for row I of ROOM_TABLE
+template <uint8_t I>
+struct RoomTraits {
+  static constexpr const RoomDef &def() { return ROOM_TABLE[I]; }
+  static constexpr uint8_t PROBES = ROOM_TABLE[I].probeCount;
+  static constexpr uint8_t ZONES  = ROOM_TABLE[I].zoneCount;
+  static constexpr bool has(uint8_t relay) { return ROOM_TABLE[I].relayPins[relay] != NO_PIN; }
+};
+
+typedef RoomController<RoomTraits<0>> VegRoom;
+typedef RoomController<RoomTraits<1>> FlowerRoom;
+
+// Zone relays are named after their zone, the rest after their channel
+inline const char *relayLabel(uint8_t room, uint8_t ch) {
+  const RoomDef &d = ROOM_TABLE[room];
+  for (uint8_t z = 0; z < d.zoneCount; z++) if (d.zones[z].relay == ch) return d.zones[z].name;
+  return RELAY_NAMES[ch];
+}
+
+// Every room, in ROOM_TABLE order (defined in the sketch)
+extern Room *const rooms[ROOM_COUNT];
+
+#endif
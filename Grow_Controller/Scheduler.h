@@ -0,0 +1,90 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "Config.h"
+#include "Perf.h"
+
+// ---------- Cooperative deadline scheduler ----------
+// Each task runs at its own period. run() executes every task whose
+// deadline has passed, then sleeps only until the earliest next deadline.
+// Deadlines are 64-bit millis64() values, so they never wrap.
+// With PERF_ENABLED every task is timed and its start lateness recorded.
+
+typedef void (*TaskFn)();
+
+struct Task {
+  const char*   name;
+  TaskFn        fn;
+  unsigned long periodMs;
+  uint64_t      nextDue;
+#if PERF_ENABLED
+  PerfStat      perf;
+#endif
+};
+
+class Scheduler {
+public:
+  static const int MAX_TASKS = 16;
+
+  // Register a task; first run happens offsetMs after now.
+  int add(const char* name, TaskFn fn, unsigned long periodMs, unsigned long offsetMs = 0) {
+    if (count >= MAX_TASKS) return -1;
+    Task &t = tasks[count];
+    t.name = name;
+    t.fn = fn;
+    t.periodMs = periodMs;
+    t.nextDue = millis64() + offsetMs;
+#if PERF_ENABLED
+    perf.add(t.perf, name, true);
+#endif
+    return count++;
+  }
+
+  // Pull a task's deadline forward so it runs on the next pass.
+  void trigger(int id) {
+    if (id >= 0 && id < count) tasks[id].nextDue = millis64();
+  }
+
+  // Run all due tasks, return ms until the next deadline.
+  unsigned long runDue() {
+    for (int i = 0; i < count; i++) {
+      Task &t = tasks[i];
+      if (millis64() < t.nextDue) continue;
+#if PERF_ENABLED
+      t.perf.recordLate((uint32_t)micros() - (uint32_t)(t.nextDue * 1000UL), t.periodMs * 1000UL);
+      uint32_t c0 = halCycles();
+      t.fn();
+      t.perf.record(halCycles() - c0);
+#else
+      t.fn();
+#endif
+      t.nextDue += t.periodMs;
+      // fell more than one period behind: skip missed slots instead of bursting
+      uint64_t now = millis64();
+      if (now >= t.nextDue) t.nextDue = now + t.periodMs;
+    }
+    return msUntilNext();
+  }
+
+  unsigned long msUntilNext() const {
+    uint64_t now = millis64();
+    unsigned long wait = ~0UL;
+    for (int i = 0; i < count; i++) {
+      if (tasks[i].nextDue <= now) return 0;
+      if (tasks[i].nextDue - now < wait) wait = tasks[i].nextDue - now;
+    }
+    return count ? wait : 0;
+  }
+
+  // One scheduler pass followed by an idle sleep until the next deadline.
+  void run() {
+    unsigned long wait = runDue();
+    if (wait) delay(wait);
+  }
+
+private:
+  Task tasks[MAX_TASKS];
+  int  count = 0;
+};
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef SOILCALIBRATION_H
+#define SOILCALIBRATION_H
+
+#include "SoilSensors.h"
+#include "ConfigStore.h"   // crc32
+#include "Log.h"
+
+#define SOIL_CAL_NS        "soilcal"
+#define SOIL_CAL_KEY       "probes"
+#define SOIL_CAL_VERSION   1
+#define SOIL_CAL_WET_PCT   100   // what `soilcal <pin> wet` records
+#define SOIL_CAL_MIN_GAP   16    // counts; a capture this close to a point replaces it
+#define SOIL_WEIGHT_MAX    9
+
+// ---------- Soil probe calibration ----------
+// Curves for SoilSensors, captured from the console with the probe in
+// place: `soilcal <pin> dry` in dry mix, `soilcal <pin> wet` in saturated
+// mix and, optionally, `soilcal <pin> <pct>` at moistures measured some
+// other way (a reference meter, or weighing a sample). Every capture
+// takes the probe's current filtered counts. A probe keeps the default
+// curve until it has two points.
+//
+// NVS holds one small blob: a header, then for each probe that differs
+// from the defaults its pin, weight, point count and points, 3 bytes
+// each (12-bit counts, 12-bit 0.1 %). Captures are rare and deliberate,
+// so each one is written at once rather than coalesced.
+
+struct SoilCalHeader {
+  uint16_t version;
+  uint8_t  probes;
+  uint8_t  reserved;
+  uint32_t crc;   // CRC-32 of the records
+};
+
+#define SOIL_CAL_BLOB_MAX  (sizeof(SoilCalHeader) + SOIL_MAX_CHANNELS * (3 + 3 * SOIL_CAL_POINTS))
+
+class SoilCalibration {
+public:
+  enum Result { CAL_OK, CAL_UNKNOWN_PIN, CAL_NO_READING, CAL_FULL, CAL_NOT_MONOTONIC, CAL_SAVE_FAILED };
+
+  // After the rooms registered their probes
+  void load() {
+    uint8_t buf[SOIL_CAL_BLOB_MAX];
+    logger.add(logSrc);
+    prefs.begin(SOIL_CAL_NS, true);
+    size_t len = prefs.getBytes(SOIL_CAL_KEY, buf, sizeof(buf));
+    prefs.end();
+    if (len == 0) return;
+    if (!decode(buf, len)) { logger.warn(logSrc, "⚠️ Stored soil calibration corrupt, using defaults"); return; }
+
+    uint8_t curves = 0;
+    for (uint8_t i = 0; i < used; i++) {
+      soilSensors.setWeight(probes[i].pin, probes[i].weight);
+      if (probes[i].n >= 2 && soilSensors.setCurve(probes[i].pin, probes[i].pts, probes[i].n)) curves++;
+    }
+    logger.info(logSrc, "✅ Soil calibration loaded, %u probe curves", curves);
+  }
+
+  // Record the probe's current reading as permille (0.1 %) moisture
+  Result capture(int pin, uint16_t permille) {
+    if (!soilSensors.known(pin)) return CAL_UNKNOWN_PIN;
+    float counts = soilSensors.value(pin);
+    if (isnan(counts)) return CAL_NO_READING;
+    Probe *p = find(pin, true);
+    if (!p) return CAL_FULL;
+
+    Probe next = *p;
+    SoilCalPoint pt = { (uint16_t)lroundf(counts), permille };
+    uint8_t at = 0;
+    while (at < next.n && (next.pts[at].permille != permille && abs(next.pts[at].raw - pt.raw) > SOIL_CAL_MIN_GAP))
+      at++;
+    if (at < next.n) remove(next, at);   // same moisture or too close: replace it
+    if (next.n >= SOIL_CAL_POINTS) return CAL_FULL;
+    for (at = next.n; at > 0 && next.pts[at - 1].raw > pt.raw; at--) next.pts[at] = next.pts[at - 1];
+    next.pts[at] = pt;
+    next.n++;
+
+    if (next.n >= 2 && !soilSensors.setCurve(pin, next.pts, next.n)) return CAL_NOT_MONOTONIC;
+    *p = next;
+    return save();
+  }
+
+  // Back to the default curve; the weight stays
+  Result clear(int pin) {
+    if (!soilSensors.known(pin)) return CAL_UNKNOWN_PIN;
+    Probe *p = find(pin, false);
+    if (!p) return CAL_OK;
+    soilSensors.setCurve(pin, nullptr, 0);
+    p->n = 0;
+    return save();
+  }
+
+  Result setWeight(int pin, uint8_t w) {
+    if (!soilSensors.known(pin)) return CAL_UNKNOWN_PIN;
+    Probe *p = find(pin, true);
+    if (!p) return CAL_FULL;
+    p->weight = w;
+    soilSensors.setWeight(pin, w);
+    return save();
+  }
+
+  // A probe's captured points, sorted by counts; their number
+  uint8_t points(int pin, const SoilCalPoint *&pts) const {
+    for (uint8_t i = 0; i < used; i++)
+      if (probes[i].pin == pin) { pts = probes[i].pts; return probes[i].n; }
+    return 0;
+  }
+
+private:
+  struct Probe {
+    uint8_t      pin;
+    uint8_t      weight;
+    uint8_t      n;
+    SoilCalPoint pts[SOIL_CAL_POINTS];
+  };
+
+  Probe     probes[SOIL_MAX_CHANNELS];
+  uint8_t   used = 0;
+  LogSource logSrc{"soilcal"};
+
+  Probe *find(int pin, bool create) {
+    for (uint8_t i = 0; i < used; i++) if (probes[i].pin == pin) return &probes[i];
+    if (!create || used >= SOIL_MAX_CHANNELS) return nullptr;
+    Probe &p = probes[used++];
+    p.pin = pin;
+    p.weight = soilSensors.weight(pin);
+    p.n = 0;
+    return &p;
+  }
+
+  static void remove(Probe &p, uint8_t at) {
+    for (uint8_t i = at; i + 1 < p.n; i++) p.pts[i] = p.pts[i + 1];
+    p.n--;
+  }
+
+  Result save() {
+    uint8_t buf[SOIL_CAL_BLOB_MAX];
+    SoilCalHeader hdr = { SOIL_CAL_VERSION, 0, 0, 0 };
+    size_t len = sizeof(hdr);
+    for (uint8_t i = 0; i < used; i++) {
+      const Probe &p = probes[i];
+      if (!p.n && p.weight == SOIL_WEIGHT_DEFAULT) continue;   // nothing the defaults lack
+      buf[len++] = p.pin;
+      buf[len++] = p.weight;
+      buf[len++] = p.n;
+      for (uint8_t k = 0; k < p.n; k++) {
+        buf[len++] = p.pts[k].raw & 0xFF;
+        buf[len++] = (p.pts[k].raw >> 8 & 0x0F) | (p.pts[k].permille & 0x0F) << 4;
+        buf[len++] = p.pts[k].permille >> 4;
+      }
+      hdr.probes++;
+    }
+    hdr.crc = crc32(buf + sizeof(hdr), len - sizeof(hdr));
+    memcpy(buf, &hdr, sizeof(hdr));
+
+    prefs.begin(SOIL_CAL_NS, false);
+    bool ok = prefs.putBytes(SOIL_CAL_KEY, buf, len) == len;
+    prefs.end();
+    if (ok) return CAL_OK;
+    logger.error(logSrc, "❌ Soil calibration write failed");
+    return CAL_SAVE_FAILED;
+  }
+
+  bool decode(const uint8_t *buf, size_t len) {
+    SoilCalHeader hdr;
+    if (len < sizeof(hdr)) return false;
+    memcpy(&hdr, buf, sizeof(hdr));
+    if (hdr.version != SOIL_CAL_VERSION || crc32(buf + sizeof(hdr), len - sizeof(hdr)) != hdr.crc) return false;
+
+    size_t pos = sizeof(hdr);
+    for (uint8_t i = 0; i < hdr.probes; i++) {
+      if (pos + 3 > len) return false;
+      uint8_t pin = buf[pos], weight = buf[pos + 1], n = buf[pos + 2];
+      pos += 3;
+      if (n > SOIL_CAL_POINTS || pos + 3 * n > len) return false;
+      Probe *p = soilSensors.known(pin) ? find(pin, true) : nullptr;   // probe since removed: skip
+      for (uint8_t k = 0; k < n; k++, pos += 3) {
+        if (!p) continue;
+        p->pts[k].raw = buf[pos] | (buf[pos + 1] & 0x0F) << 8;
+        p->pts[k].permille = buf[pos + 1] >> 4 | buf[pos + 2] << 4;
+      }
+      if (p) { p->weight = weight; p->n = n; }
+    }
+    return true;
+  }
+};
+
+extern SoilCalibration soilCal;
+
+#endif
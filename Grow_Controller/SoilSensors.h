@@ -0,0 +1,257 @@
+#ifndef SOILSENSORS_H
+#define SOILSENSORS_H
+
+#include "Config.h"
+#include "Hal.h"
+#include "Log.h"
+
+// === Soil acquisition tuning ===
+#define SOIL_MAX_CHANNELS     16
+#define SOIL_MEDIAN_TAPS       5     // spike rejection window (samples)
+#define SOIL_IIR_SHIFT         4     // low-pass alpha = 1/16 per sample
+#define SOIL_OVERSAMPLE       32     // DMA conversions averaged into one sample
+#define SOIL_CONVERT_HZ    20000     // ADC conversion rate across all channels
+#define SOIL_RAIL_LOW         40     // median below: probe shorted or unpowered
+#define SOIL_RAIL_HIGH      4050     // median above: probe disconnected
+#define SOIL_STUCK_SAMPLES   600     // identical raw samples before flagging stuck
+#define SOIL_ONESHOT_READS     8     // reads averaged per sample when DMA is turned off
+
+// === Calibration ===
+#define SOIL_CAL_POINTS        6     // points per probe curve
+#define SOIL_DRY_RAW        1000     // uncalibrated probes: counts at 0 %
+#define SOIL_WET_RAW        3500     //   and at 100 %
+#define SOIL_OUTLIER_PCT      15     // probes further than this from the zone median are left out
+#define SOIL_WEIGHT_DEFAULT    1     // a probe's weight in its zone average
+
+// ---------- Soil moisture acquisition ----------
+// ADC1 pins are converted continuously by the DMA driver (oversampled and
+// averaged in hardware); other pins fall back to a one-shot read from the
+// acquisition task. poll() pushes one sample per channel through a
+// median-of-5 spike filter and a fixed-point IIR low-pass, laid out as
+// structure-of-arrays so the per-channel loops vectorise. Control code
+// only ever reads the finished value, O(1) and without touching the ADC.
+//
+// Each channel converts counts to moisture % through its own
+// piecewise-linear curve (captured and stored by SoilCalibration.h;
+// SOIL_DRY_RAW..SOIL_WET_RAW until then). Points are sorted by counts and
+// each segment's slope is precomputed in Q16, so a lookup is a short scan,
+// one multiply and a shift. Readings past the end points follow the end
+// segment and are clamped to 0..100 %.
+
+// One calibration point: filtered counts and the moisture they stand for, in 0.1 %
+struct SoilCalPoint {
+  uint16_t raw;
+  uint16_t permille;
+};
+
+class SoilSensors {
+public:
+  enum Fault : uint8_t { PROBE_OK, PROBE_RAIL, PROBE_STUCK };
+
+  SoilSensors() { memset(chOfPin, -1, sizeof(chOfPin)); }
+
+  // Register a probe pin before begin(); returns its channel or -1.
+  int add(int pin) {
+    if (pin < 0 || pin >= 40) return -1;
+    if (chOfPin[pin] >= 0) return chOfPin[pin];
+    if (count >= SOIL_MAX_CHANNELS) return -1;
+    pins[count] = pin;
+    chOfPin[pin] = count;
+    weights[count] = SOIL_WEIGHT_DEFAULT;
+    setCurve(pin, nullptr, 0);
+    return count++;
+  }
+
+  // dma false: every probe is read one-shot, SOIL_ONESHOT_READS averaged
+  // per sample (power save: the DMA driver keeps the chip from sleeping)
+  void begin(bool dma = true) {
+    uint8_t dmaPins[SOIL_MAX_CHANNELS];
+    size_t n = 0;
+    logger.add(logSrc);
+    for (uint8_t ch = 0; ch < count; ch++)
+      if (isAdc1(pins[ch])) dmaPins[n++] = pins[ch];
+    if (!dma) { oneShotReads = SOIL_ONESHOT_READS; return; }
+    streaming = n && adcStreamBegin(dmaPins, n, SOIL_OVERSAMPLE, SOIL_CONVERT_HZ);
+    if (!streaming && n) logger.warn(logSrc, "⚠️ ADC DMA unavailable, soil probes use one-shot reads");
+  }
+
+  // Collect the newest sample for every channel and run the filter stage.
+  void poll() {
+    if (streaming) {
+      uint8_t  p[SOIL_MAX_CHANNELS];
+      uint16_t v[SOIL_MAX_CHANNELS];
+      int n = adcStreamRead(p, v, SOIL_MAX_CHANNELS);
+      for (int i = 0; i < n; i++) if (chOfPin[p[i]] >= 0) raw[chOfPin[p[i]]] = v[i];
+    }
+    for (uint8_t ch = 0; ch < count; ch++) {
+      if (streaming && isAdc1(pins[ch])) continue;
+      uint32_t sum = 0;
+      for (uint8_t i = 0; i < oneShotReads; i++) sum += analogRead(pins[ch]);
+      raw[ch] = sum / oneShotReads;
+    }
+    filter();
+  }
+
+  // Filtered counts for a probe, NAN if unknown or faulted.
+  float value(int pin) const {
+    int ch = channel(pin);
+    if (ch < 0 || !primed || faults[ch] != PROBE_OK) return NAN;
+    return iirQ8[ch] / 256.0f;
+  }
+
+  // Moisture % of a probe through its curve, NAN if unknown or faulted.
+  float moisture(int pin) const {
+    int ch = channel(pin);
+    if (ch < 0 || !primed || faults[ch] != PROBE_OK) return NAN;
+    return permille(ch) / 10.0f;
+  }
+
+  // Weighted moisture % of the healthy probes in the list, NAN if none
+  // are healthy. With three or more, probes further than SOIL_OUTLIER_PCT
+  // from their median are left out; weight 0 leaves a probe out for good.
+  float average(const int *probePins, int n) const {
+    int16_t pm[SOIL_MAX_CHANNELS], sorted[SOIL_MAX_CHANNELS];
+    uint8_t w[SOIL_MAX_CHANNELS];
+    int used = 0;
+    for (int i = 0; i < n && used < SOIL_MAX_CHANNELS; i++) {
+      int ch = channel(probePins[i]);
+      if (ch < 0 || !primed || faults[ch] != PROBE_OK || !weights[ch]) continue;
+      pm[used] = permille(ch);
+      w[used++] = weights[ch];
+    }
+    if (!used) return NAN;
+
+    memcpy(sorted, pm, used * sizeof(pm[0]));
+    for (int i = 1; i < used; i++)   // insertion sort, a handful of probes
+      for (int j = i; j > 0 && sorted[j - 1] > sorted[j]; j--) {
+        int16_t t = sorted[j]; sorted[j] = sorted[j - 1]; sorted[j - 1] = t;
+      }
+    int32_t median = (sorted[(used - 1) / 2] + sorted[used / 2]) / 2;
+
+    int32_t sum = 0, wsum = 0;
+    for (int i = 0; i < used; i++) {
+      if (used >= 3 && abs(pm[i] - median) > SOIL_OUTLIER_PCT * 10) continue;
+      sum += (int32_t)pm[i] * w[i];
+      wsum += w[i];
+    }
+    return (wsum ? (float)sum / wsum : median) / 10.0f;
+  }
+
+  // Install a probe's curve: points sorted by rising counts, moisture
+  // strictly rising or strictly falling along them. n 0 restores the
+  // default curve. False (curve unchanged) if the points do not qualify.
+  bool setCurve(int pin, const SoilCalPoint *pts, uint8_t n) {
+    static const SoilCalPoint DEFAULT_CURVE[2] = { { SOIL_DRY_RAW, 0 }, { SOIL_WET_RAW, 1000 } };
+    int ch = channel(pin);
+    if (ch < 0) return false;
+    if (n == 0) { pts = DEFAULT_CURVE; n = 2; }
+    if (n < 2 || n > SOIL_CAL_POINTS) return false;
+    bool rising = pts[1].permille > pts[0].permille;
+    for (uint8_t i = 1; i < n; i++)
+      if (pts[i].raw <= pts[i - 1].raw || pts[i].permille > 1000 || pts[i].permille == pts[i - 1].permille ||
+          (pts[i].permille > pts[i - 1].permille) != rising) return false;
+    for (uint8_t i = 0; i < n; i++) {
+      calRaw[ch][i] = pts[i].raw;
+      calPm[ch][i] = pts[i].permille;
+      if (i) calSlope[ch][i - 1] = ((int32_t)(pts[i].permille - pts[i - 1].permille) << 16) /
+                                   (int32_t)(pts[i].raw - pts[i - 1].raw);
+    }
+    calCount[ch] = n;
+    return true;
+  }
+
+  void setWeight(int pin, uint8_t w) {
+    int ch = channel(pin);
+    if (ch >= 0) weights[ch] = w;
+  }
+
+  uint8_t weight(int pin) const {
+    int ch = channel(pin);
+    return ch < 0 ? 0 : weights[ch];
+  }
+
+  bool known(int pin) const { return channel(pin) >= 0; }
+
+  Fault fault(int pin) const {
+    int ch = channel(pin);
+    return ch < 0 ? PROBE_RAIL : (Fault)faults[ch];
+  }
+
+private:
+  uint8_t pins[SOIL_MAX_CHANNELS];
+  int8_t  chOfPin[40];
+  uint8_t count = 0;
+  bool    streaming = false;
+  uint8_t oneShotReads = 1;
+  bool    primed = false;
+  LogSource logSrc{"soil"};
+
+  // filter state, one column per channel
+  uint16_t raw[SOIL_MAX_CHANNELS] = {};
+  uint16_t taps[SOIL_MEDIAN_TAPS][SOIL_MAX_CHANNELS] = {};
+  uint8_t  tapPos = 0;
+  int32_t  iirQ8[SOIL_MAX_CHANNELS] = {};
+  uint16_t lastRaw[SOIL_MAX_CHANNELS] = {};
+  uint16_t sameRun[SOIL_MAX_CHANNELS] = {};
+  uint8_t  faults[SOIL_MAX_CHANNELS] = {};
+
+  // calibration curves, one row per channel
+  uint16_t calRaw[SOIL_MAX_CHANNELS][SOIL_CAL_POINTS];
+  int16_t  calPm[SOIL_MAX_CHANNELS][SOIL_CAL_POINTS];
+  int32_t  calSlope[SOIL_MAX_CHANNELS][SOIL_CAL_POINTS - 1];   // 0.1 % per count, Q16
+  uint8_t  calCount[SOIL_MAX_CHANNELS] = {};
+  uint8_t  weights[SOIL_MAX_CHANNELS] = {};
+
+  static_assert(SOIL_MEDIAN_TAPS == 5, "filter uses a fixed median-of-5 network");
+
+  static bool isAdc1(int pin) { return pin >= 32 && pin <= 39; }
+
+  int channel(int pin) const { return (pin >= 0 && pin < 40) ? chOfPin[pin] : -1; }
+
+  // Filtered value through the channel's curve, 0..1000
+  int16_t permille(uint8_t ch) const {
+    int32_t x = iirQ8[ch];   // counts, Q8
+    const uint16_t *raw = calRaw[ch];
+    uint8_t seg = 0;
+    while (seg + 2 < calCount[ch] && x >= (int32_t)raw[seg + 1] << 8) seg++;
+    int64_t dx = x - ((int32_t)raw[seg] << 8);
+    int32_t pm = calPm[ch][seg] + (int32_t)((dx * calSlope[ch][seg]) >> 24);
+    return pm < 0 ? 0 : pm > 1000 ? 1000 : pm;
+  }
+
+  static inline void sort2(uint16_t &a, uint16_t &b) {
+    uint16_t lo = a < b ? a : b, hi = a < b ? b : a;
+    a = lo; b = hi;
+  }
+
+  void filter() {
+    for (uint8_t ch = 0; ch < count; ch++) taps[tapPos][ch] = raw[ch];
+    if (!primed)   // fill the window so the first median is the first sample
+      for (uint8_t t = 0; t < SOIL_MEDIAN_TAPS; t++)
+        for (uint8_t ch = 0; ch < count; ch++) taps[t][ch] = raw[ch];
+    tapPos = (tapPos + 1) % SOIL_MEDIAN_TAPS;
+
+    for (uint8_t ch = 0; ch < count; ch++) {
+      // branch-free median-of-5 network
+      uint16_t a = taps[0][ch], b = taps[1][ch], c = taps[2][ch], d = taps[3][ch], e = taps[4][ch];
+      sort2(a, b); sort2(d, e); sort2(a, d);
+      sort2(b, e); sort2(b, c); sort2(c, d);
+      sort2(b, c);
+      int32_t med = c;
+
+      iirQ8[ch] = primed ? iirQ8[ch] + (((med << 8) - iirQ8[ch]) >> SOIL_IIR_SHIFT) : med << 8;
+
+      sameRun[ch] = (raw[ch] == lastRaw[ch]) ? sameRun[ch] + (sameRun[ch] < 0xFFFF) : 0;
+      lastRaw[ch] = raw[ch];
+
+      faults[ch] = (med < SOIL_RAIL_LOW || med > SOIL_RAIL_HIGH) ? PROBE_RAIL
+                 : (sameRun[ch] >= SOIL_STUCK_SAMPLES)           ? PROBE_STUCK
+                 : PROBE_OK;
+    }
+    primed = true;
+  }
+};
+
+extern SoilSensors soilSensors;
+
+#endif
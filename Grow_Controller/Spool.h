@@ -0,0 +1,183 @@
+#ifndef SPOOL_H
+#define SPOOL_H
+
+#include <stddef.h>
+#include "Hal.h"
+#include "ConfigStore.h"   // crc32
+
+#define SPOOL_BYTES   (512UL * 1024)   // flash given to the ring, at most the partition
+#define SPOOL_MAGIC   0x5350           // "SP"
+#define SPOOL_LIVE    0xFFFFFFFFUL     // erased: not delivered yet
+
+// ---------- Flash spool ----------
+// Store-and-forward ring for MQTT batches (MqttReporter.h) on raw NOR
+// flash. Each record is a header and its payload, 4-byte aligned, and
+// never crosses a sector. The payload is written before the header, so a
+// reset mid-write leaves no header or one whose CRC fails. Delivery
+// clears the header's `live` word in place (NOR writes only clear bits),
+// so nothing is rewritten until the ring wraps: the writer erases the
+// next sector on entry, dropping any undelivered records still in it.
+//
+// begin() rebuilds the state from flash: the oldest live record (lowest
+// seq) is the read position, and writing resumes in the sector after the
+// newest record, so a reset never appends to a half-written sector.
+// Records are only ever read oldest first, so delivery order is append
+// order, across resets too.
+
+struct SpoolRecord {
+  uint16_t magic;
+  uint16_t len;    // payload bytes
+  uint32_t seq;
+  uint32_t crc;    // over seq and payload
+  uint32_t live;   // SPOOL_LIVE until delivered, then 0
+};
+
+class Spool {
+public:
+  uint32_t written = 0;   // records appended since boot
+  uint32_t dropped = 0;   // undelivered records overwritten or unreadable
+
+  bool begin() {
+    size = halSpoolSize();
+    if (size > SPOOL_BYTES) size = SPOOL_BYTES;
+    size -= size % HAL_SPOOL_SECTOR;
+    if (size < 2 * HAL_SPOOL_SECTOR) { size = 0; return false; }
+
+    bool found = false;
+    uint32_t minLive = UINT32_MAX;
+    count = 0;
+    head = 0;
+    for (uint32_t sector = 0; sector < size; sector += HAL_SPOOL_SECTOR) {
+      SpoolRecord r;
+      for (uint32_t off = sector; off - sector < HAL_SPOOL_SECTOR && header(off, r); off += recLen(r.len)) {
+        if (!intact(off, r)) continue;
+        if (!found || r.seq > newest) { newest = r.seq; head = sector; found = true; }
+        if (r.live != SPOOL_LIVE) continue;
+        count++;
+        if (r.seq < minLive) { minLive = r.seq; tail = off; }
+      }
+    }
+    if (found) head = nextSector(head);
+    return true;
+  }
+
+  bool     ready() const   { return size != 0; }
+  uint32_t pending() const { return count; }
+  uint32_t lastSeq() const { return newest; }   // highest seq in flash, 0 if none
+  uint32_t bytes() const   { return size; }
+
+  bool append(uint32_t seq, const void *data, size_t len) {
+    if (!size || len > HAL_SPOOL_SECTOR - sizeof(SpoolRecord)) return false;
+    uint32_t need = recLen(len);
+    if (head % HAL_SPOOL_SECTOR + need > HAL_SPOOL_SECTOR) head = nextSector(head);
+    if (head % HAL_SPOOL_SECTOR == 0 && !claim(head)) return false;
+
+    SpoolRecord r = { SPOOL_MAGIC, (uint16_t)len, seq, checksum(seq, data, len), SPOOL_LIVE };
+    if (!halSpoolWrite(head + sizeof(r), data, len) || !halSpoolWrite(head, &r, sizeof(r))) return false;
+    if (!count) tail = head;
+    count++;
+    written++;
+    newest = seq;
+    head += need;
+    if (head >= size) head = 0;
+    return true;
+  }
+
+  // Oldest undelivered record into buf; its length, 0 if none
+  size_t peek(void *buf, size_t max, uint32_t &seq) {
+    while (count) {
+      SpoolRecord r;
+      if (header(tail, r) && r.len <= max && halSpoolRead(tail + sizeof(r), buf, r.len) &&
+          checksum(r.seq, buf, r.len) == r.crc) {
+        seq = r.seq;
+        return r.len;
+      }
+      dropped++;   // went bad since the scan: skip it
+      markSent();
+    }
+    return 0;
+  }
+
+  // The record peek() returned was delivered
+  void markSent() {
+    if (!count) return;
+    uint32_t zero = 0;
+    halSpoolWrite(tail + offsetof(SpoolRecord, live), &zero, sizeof(zero));
+    if (--count) tail = seekLive(after(tail));
+  }
+
+private:
+  uint32_t size = 0;
+  uint32_t head = 0;    // next write
+  uint32_t tail = 0;    // oldest live record, while count > 0
+  uint32_t count = 0;
+  uint32_t newest = 0;
+
+  static uint32_t recLen(uint16_t len) { return (sizeof(SpoolRecord) + len + 3) & ~3UL; }
+
+  uint32_t nextSector(uint32_t off) const {
+    uint32_t s = off - off % HAL_SPOOL_SECTOR + HAL_SPOOL_SECTOR;
+    return s >= size ? 0 : s;
+  }
+
+  // A plausible header at off (CRC not checked)
+  bool header(uint32_t off, SpoolRecord &r) const {
+    uint32_t in = off % HAL_SPOOL_SECTOR;
+    if (in + sizeof(r) > HAL_SPOOL_SECTOR || !halSpoolRead(off, &r, sizeof(r))) return false;
+    return r.magic == SPOOL_MAGIC && in + recLen(r.len) <= HAL_SPOOL_SECTOR;
+  }
+
+  static uint32_t checksum(uint32_t seq, const void *data, size_t len) {
+    return crc32((const uint8_t *)data, len, crc32((const uint8_t *)&seq, sizeof(seq)));
+  }
+
+  // Payload matches the header's CRC; read in small steps, no buffer needed
+  bool intact(uint32_t off, const SpoolRecord &r) const {
+    uint8_t chunk[64];
+    uint32_t crc = crc32((const uint8_t *)&r.seq, sizeof(r.seq));
+    for (uint16_t done = 0; done < r.len;) {
+      uint16_t n = r.len - done;
+      if (n > sizeof(chunk)) n = sizeof(chunk);
+      if (!halSpoolRead(off + sizeof(r) + done, chunk, n)) return false;
+      crc = crc32(chunk, n, crc);
+      done += n;
+    }
+    return crc == r.crc;
+  }
+
+  // Record after off, or the next sector once this one has no more
+  uint32_t after(uint32_t off) const {
+    SpoolRecord r;
+    if (!header(off, r)) return nextSector(off);
+    uint32_t n = off + recLen(r.len);
+    return n % HAL_SPOOL_SECTOR && header(n, r) ? n : nextSector(off);
+  }
+
+  // First live, intact record from off on
+  uint32_t seekLive(uint32_t off) {
+    for (uint32_t guard = size / sizeof(SpoolRecord); guard--; off = after(off)) {
+      SpoolRecord r;
+      if (header(off, r) && r.live == SPOOL_LIVE && intact(off, r)) return off;
+    }
+    count = 0;   // lost track: nothing left worth sending
+    return off;
+  }
+
+  // Erase a sector before writing into it
+  bool claim(uint32_t sector) {
+    SpoolRecord r;
+    uint32_t lost = 0;
+    for (uint32_t off = sector; off - sector < HAL_SPOOL_SECTOR && header(off, r); off += recLen(r.len))
+      if (r.live == SPOOL_LIVE && intact(off, r)) lost++;
+    bool hadTail = count && tail - sector < HAL_SPOOL_SECTOR;
+    if (!halSpoolErase(sector)) return false;
+    if (lost) {
+      dropped += lost;
+      count = lost < count ? count - lost : 0;
+    }
+    if (hadTail && count) tail = seekLive(nextSector(sector));
+    return true;
+  }
+};
+
+#endif
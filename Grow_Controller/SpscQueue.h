@@ -0,0 +1,44 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+
+// ---------- Bounded single-producer / single-consumer queue ----------
+// Lock-free: one task pushes, one task pops, no mutex and no blocking.
+// A full queue rejects the push so the producer never waits on the consumer.
+template <typename T, size_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+  bool push(const T &item) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= N) { dropped++; return false; }
+    buf[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T &out) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    out = buf[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+  }
+
+  // producer-side count of rejected pushes
+  unsigned long dropped = 0;
+
+private:
+  T buf[N];
+  std::atomic<size_t> head{0};   // written by producer only
+  std::atomic<size_t> tail{0};   // written by consumer only
+};
+
+#endif
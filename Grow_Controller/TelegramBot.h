@@ -1,89 +1,120 @@
-#ifndef TELEGRAMBOT_H
-#define TELEGRAMBOT_H
-
-#include <WiFi.h>
-#include <WiFiClientSecure.h>
-#include <UniversalTelegramBot.h>
-#include <ArduinoJson.h>
-#include "Console.h"
-#include "OTAUpdate.h"
-
-// --- credentials ---
-const char* WIFI_SSID = "YourSSID";
-const char* WIFI_PASS = "YourPassword";
-const char* BOT_TOKEN = "123456789:ABCDEF";  // from @BotFather
-const String CHAT_ID  = "123456789";         // your own chat id
-
-WiFiClientSecure secureClient;
-UniversalTelegramBot bot(BOT_TOKEN, secureClient);
-
-unsigned long lastBotCheck = 0;
-const unsigned long BOT_INTERVAL = 5000;
-
-// ------------------------------------------------------------------
-void initWiFi() {
-  Serial.printf("Connecting to %s ...\n", WIFI_SSID);
-  WiFi.begin(WIFI_SSID, WIFI_PASS);
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");
-  }
-  Serial.println("\n✅ WiFi connected");
-  secureClient.setCACert(TELEGRAM_CERTIFICATE_ROOT);
-}
-
-// ------------------------------------------------------------------
-void handleTelegram(float temp, float hum, float motherSoil) {
-  if (millis() - lastBotCheck < BOT_INTERVAL) return;
-  lastBotCheck = millis();
-
-  int newMsgs = bot.getUpdates(bot.last_message_received + 1);
-  while (newMsgs) {
-    for (int i=0; i<newMsgs; i++) {
-      String chat_id = String(bot.messages[i].chat_id);
-      String text = bot.messages[i].text;
-
-      if (chat_id != CHAT_ID) continue;
-
-      if (text == "/start") {
-        bot.sendMessage(CHAT_ID,
-          "🌿 Greenhouse Bot ready.\n"
-          "Commands:\n"
-          "/status – show readings\n"
-          "/set <room> <param> <value>\n"
-          "/update – pull latest firmware\n"
-          "/reboot – restart controller\n"
-          "/help – show this list", "");
-      }
-      else if (text == "/status") {
-        char buf[200];
-        sprintf(buf, "Temp: %.1f°C\nHum: %.1f%%\nMother soil: %.0f",
-                temp, hum, motherSoil);
-        bot.sendMessage(CHAT_ID, buf, "");
-      }
-      else if (text.startsWith("/set ")) {
-        Serial.println(text.substring(1)); // feed to serial handler
-        handleSerial(temp, hum, motherSoil);
-        bot.sendMessage(CHAT_ID, "✅ Command executed", "");
-      }
-      else if (text == "/update") {
-        bot.sendMessage(CHAT_ID, "⬇️ Fetching latest firmware...", "");
-        performOTA();
-      }
-      else if (text == "/reboot") {
-        bot.sendMessage(CHAT_ID, "♻️ Rebooting...", "");
-        delay(1000);
-        ESP.restart();
-      }
-      else if (text == "/help") {
-        bot.sendMessage(CHAT_ID,
-          "Usage:\n/status\n/set <room> <param> <value>\n/update\n/reboot", "");
-      }
-      else {
-        bot.sendMessage(CHAT_ID, "Unknown command. Use /help", "");
-      }
-    }
-    newMsgs = bot.getUpdates(bot.last_message_received + 1);
-  }
-}
-#endif
+#ifndef TELEGRAMBOT_H
+#define TELEGRAMBOT_H
+
+#include <WiFiClientSecure.h>
+#include <UniversalTelegramBot.h>
+#include <ArduinoJson.h>
+#include "Link.h"
+#include "OTAUpdate.h"
+#include "Perf.h"
+#include "WifiManager.h"
+
+// --- credentials ---
+const char* BOT_TOKEN = "123456789:ABCDEF";  // from @BotFather
+const String CHAT_ID  = "123456789";         // your own chat id
+
+WiFiClientSecure secureClient;
+UniversalTelegramBot bot(BOT_TOKEN, secureClient);
+
+#define BOT_LONG_POLL_S     15       // getUpdates is held open server-side this long
+#define BOT_REPLY_WAIT_MS   2000     // give up waiting for the control task's reply
+#define BOT_COALESCE_MS     1500     // alerts wait this long for company before sending
+#define BOT_OUTBOX_MAX      3500     // one message, below Telegram's 4096-char limit
+#define BOT_BACKOFF_MIN_MS  2000
+#define BOT_BACKOFF_MAX_MS  300000UL
+
+PerfStat perfBotSend;   // registered by startNetworkTask()
+
+// ---------- Outbound message ----------
+// Replies and alerts are appended here and go out as a single
+// sendMessage. Anything that arrives while it is full (e.g. a long
+// outage) is counted and mentioned when the message finally goes.
+struct BotOutbox {
+  char          text[BOT_OUTBOX_MAX];
+  size_t        len = 0;
+  bool          hasReply = false;
+  unsigned long firstAt = 0;
+  uint32_t      lost = 0;
+
+  void add(const char *s, bool reply) {
+    size_t n = strlen(s);
+    if (!n) return;
+    if (len + n + 2 >= sizeof(text) - 32) { lost++; return; }   // keep room for the lost note
+    if (!len) firstAt = millis();
+    else { text[len++] = '\n'; text[len++] = '\n'; }
+    memcpy(text + len, s, n);
+    len += n;
+    text[len] = '\0';
+    hasReply |= reply;
+  }
+
+  void clear() { len = 0; text[0] = '\0'; hasReply = false; lost = 0; }
+};
+
+BotOutbox     botOutbox;
+Backoff       botBackoff(BOT_BACKOFF_MIN_MS, BOT_BACKOFF_MAX_MS);
+uint8_t       botAwaiting = 0;    // commands handed to the control task, replies not yet back
+unsigned long botAwaitSince = 0;
+
+// Once per boot, before the first poll
+void initTelegram() {
+  secureClient.setCACert(TELEGRAM_CERTIFICATE_ROOT);
+  bot.longPoll = BOT_LONG_POLL_S;   // one kept-alive TLS connection carries every request
+}
+
+// ------------------------------------------------------------------
+// One long poll. Returns as soon as a message arrives, or after
+// BOT_LONG_POLL_S with nothing. Every message from our chat is handed to
+// the control task's command engine; its reply comes back through
+// replyQueue. The library drops the socket on any failure, which is how
+// an error is told apart from an empty poll.
+void pollTelegram() {
+  int newMsgs = bot.getUpdates(bot.last_message_received + 1);
+  if (!secureClient.connected()) { botBackoff.fail(); return; }
+  botBackoff.ok();
+
+  for (int i = 0; i < newMsgs; i++) {
+    if (bot.messages[i].chat_id != CHAT_ID) continue;
+
+    CommandMsg msg;
+    strlcpy(msg.text, bot.messages[i].text.c_str(), sizeof(msg.text));
+    if (commandQueue.push(msg)) { botAwaiting++; botAwaitSince = millis(); }
+    else botOutbox.add("⚠️ Controller busy, try again", true);
+  }
+}
+
+void flushOutbox() {
+  if (botOutbox.lost)
+    snprintf(botOutbox.text + botOutbox.len, sizeof(botOutbox.text) - botOutbox.len,
+             "\n\n(%lu more messages dropped)", (unsigned long)botOutbox.lost);
+  PERF_SCOPE(perfBotSend);
+  if (bot.sendMessage(CHAT_ID, botOutbox.text, "")) {
+    botOutbox.clear();
+    botBackoff.ok();
+  } else {
+    botOutbox.text[botOutbox.len] = '\0';   // drop the note, it is rebuilt on retry
+    botBackoff.fail();
+  }
+}
+
+// Runs every network tick. Replies go out once every command from the
+// last poll has answered; alerts are held briefly so a burst becomes one
+// message. Polling waits until nothing is left to send.
+void serviceTelegram() {
+  ReplyMsg reply;
+  while (replyQueue.pop(reply)) {
+    botOutbox.add(reply.text, true);
+    if (botAwaiting) botAwaiting--;
+  }
+  AlertMsg alert;
+  while (alertQueue.pop(alert)) botOutbox.add(alert.text, false);
+  if (botAwaiting && millis() - botAwaitSince >= BOT_REPLY_WAIT_MS) botAwaiting = 0;
+
+  if (!wifi.up || !botBackoff.ready() || botAwaiting) return;
+  if (botOutbox.len) {
+    if (botOutbox.hasReply || millis() - botOutbox.firstAt >= BOT_COALESCE_MS) flushOutbox();
+    return;
+  }
+  pollTelegram();
+}
+#endif
@@ -0,0 +1,113 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include "Hal.h"
+
+#define WHEEL_SLOTS    256    // power of two; one revolution = 256 ticks
+#define WHEEL_TICK_MS  1000   // resolution of scheduled events
+
+// ---------- Hashed timer wheel ----------
+// Calendar events (light transitions, flood rest periods) hang off the
+// slot for their due tick, modulo WHEEL_SLOTS. A tick only walks its own
+// slot, so its cost does not grow with the number of armed events; an
+// event more than one revolution out is simply passed over until its
+// lap comes round. Events are intrusive and owned by their caller, so
+// arming never allocates. Times are 64-bit millis64() and never wrap.
+//
+// Everything runs in the control task: arm/cancel from room code, tick()
+// from the scheduler.
+
+struct WheelEvent {
+  void       (*fn)(void *ctx) = nullptr;
+  void        *ctx   = nullptr;
+  const char  *owner = "";        // for `schedule`, e.g. the room name
+  const char  *what  = "";        // e.g. "light on"
+  uint64_t     dueMs = 0;
+  WheelEvent  *next  = nullptr;
+  uint16_t     slot  = 0;
+  bool         armed = false;
+
+  void bind(void (*f)(void *), void *c, const char *o) { fn = f; ctx = c; owner = o; }
+};
+
+class TimerWheel {
+public:
+  // Fire fn(ctx) at dueMs (or on the next tick if that has passed);
+  // re-arming an armed event moves it.
+  void arm(WheelEvent &e, uint64_t dueMs, const char *what = nullptr) {
+    cancel(e);
+    start();
+    if (what) e.what = what;
+    e.dueMs = dueMs;
+    uint64_t t = (dueMs + WHEEL_TICK_MS - 1) / WHEEL_TICK_MS;   // first tick not before dueMs
+    if (t < cur) t = cur;   // overdue: the next slot processed
+    e.slot = t & (WHEEL_SLOTS - 1);
+    e.next = slots[e.slot];
+    slots[e.slot] = &e;
+    e.armed = true;
+    armedCount++;
+  }
+
+  void cancel(WheelEvent &e) {
+    if (!e.armed) return;
+    WheelEvent **p = &slots[e.slot];
+    while (*p && *p != &e) p = &(*p)->next;
+    if (*p) *p = e.next;
+    e.armed = false;
+    e.next = nullptr;
+    armedCount--;
+  }
+
+  // Process every tick up to now. A long stall walks each slot at most once.
+  void tick(uint64_t nowMs) {
+    start();
+    uint64_t target = nowMs / WHEEL_TICK_MS;
+    if (target < cur) return;
+    uint64_t from = target - cur >= WHEEL_SLOTS ? target - WHEEL_SLOTS + 1 : cur;
+    for (uint64_t t = from; t <= target; t++) {
+      WheelEvent *&head = slots[t & (WHEEL_SLOTS - 1)];
+      // Rescan from the head after each callback: it may arm or cancel
+      // events in this slot. Slots hold a handful of events at most.
+      for (;;) {
+        WheelEvent **p = &head;
+        while (*p && (*p)->dueMs > nowMs) p = &(*p)->next;   // later laps stay put
+        if (!*p) break;
+        WheelEvent *e = *p;
+        *p = e->next;
+        e->next = nullptr;
+        e->armed = false;
+        armedCount--;
+        fired++;
+        cur = t + 1;   // anything the callback arms lands in a later slot
+        e->fn(e->ctx);
+      }
+    }
+    cur = target + 1;
+  }
+
+  // Visit every armed event (unordered)
+  template <typename F> void forEach(F f) const {
+    for (uint16_t i = 0; i < WHEEL_SLOTS; i++)
+      for (const WheelEvent *e = slots[i]; e; e = e->next) f(*e);
+  }
+
+  uint16_t size() const { return armedCount; }
+  uint32_t firedCount() const { return fired; }
+
+private:
+  WheelEvent *slots[WHEEL_SLOTS] = {};
+  uint64_t    cur = 0;          // next tick to process
+  uint16_t    armedCount = 0;
+  uint32_t    fired = 0;
+  bool        started = false;
+
+  void start() {
+    if (started) return;
+    started = true;
+    cur = millis64() / WHEEL_TICK_MS;
+  }
+};
+
+extern TimerWheel timerWheel;
+
+#endif
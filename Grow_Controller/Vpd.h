@@ -0,0 +1,64 @@
+#ifndef VPD_H
+#define VPD_H
+
+#include <stdint.h>
+
+#define SVP_MIN_C      -10   // table covers SVP_MIN_C .. SVP_MAX_C in 1 °C steps
+#define SVP_MAX_C       50
+
+// ---------- Saturation vapour pressure ----------
+// Tetens' formula over water, tabulated at compile time so the control
+// loop only does a lookup and one integer interpolation. Linear
+// interpolation between whole degrees stays within 4 Pa of the formula
+// over the whole range. The constexpr helpers are single-expression so
+// the table also builds as C++11.
+
+namespace svp_detail {
+
+constexpr double sq(double v) { return v * v; }
+
+constexpr double expSeries(double x, int n, double term, double sum) {
+  return n > 20 ? sum : expSeries(x, n + 1, term * x / n, sum + term * x / n);
+}
+
+// exp(x) = exp(x/2)^2 until the Taylor series converges fast
+constexpr double cexp(double x) {
+  return (x > 0.5 || x < -0.5) ? sq(cexp(x / 2)) : expSeries(x, 1, 1.0, 1.0);
+}
+
+constexpr double tetensPa(double c) { return 610.78 * cexp(17.27 * c / (c + 237.3)); }
+
+template <int... I> struct Seq {};
+template <int N, int... I> struct MakeSeq : MakeSeq<N - 1, N - 1, I...> {};
+template <int... I> struct MakeSeq<0, I...> { typedef Seq<I...> type; };
+
+template <typename S> struct Table;
+template <int... I> struct Table<Seq<I...>> {
+  static constexpr uint16_t pa[sizeof...(I)] = { (uint16_t)(tetensPa(SVP_MIN_C + I) + 0.5)... };
+};
+template <int... I> constexpr uint16_t Table<Seq<I...>>::pa[sizeof...(I)];
+
+}  // namespace svp_detail
+
+const int SVP_STEPS = SVP_MAX_C - SVP_MIN_C + 1;
+typedef svp_detail::Table<svp_detail::MakeSeq<SVP_STEPS>::type> SvpTable;
+
+static_assert(SvpTable::pa[0 - SVP_MIN_C] == 611 && SvpTable::pa[20 - SVP_MIN_C] == 2338,
+              "saturation table does not match Tetens");
+
+// Saturation vapour pressure (Pa) at mC milli-degrees, clamped to the table
+inline int32_t svpPa(int32_t mC) {
+  int32_t x = mC - SVP_MIN_C * 1000;
+  if (x <= 0) return SvpTable::pa[0];
+  if (x >= (SVP_STEPS - 1) * 1000) return SvpTable::pa[SVP_STEPS - 1];
+  int32_t i = x / 1000, f = x % 1000;
+  return SvpTable::pa[i] + ((SvpTable::pa[i + 1] - SvpTable::pa[i]) * f + 500) / 1000;
+}
+
+// Vapour pressure deficit (Pa): what the leaf could hold at its own
+// temperature minus what the air around it holds. rhPermille is RH × 10.
+inline int32_t vpdPa(int32_t airMc, int32_t leafMc, int32_t rhPermille) {
+  return svpPa(leafMc) - svpPa(airMc) * rhPermille / 1000;
+}
+
+#endif
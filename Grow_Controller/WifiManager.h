@@ -0,0 +1,85 @@
+#ifndef WIFIMANAGER_H
+#define WIFIMANAGER_H
+
+#include <WiFi.h>
+#include <atomic>
+#include "Log.h"
+#include "Backoff.h"
+
+// --- credentials ---
+const char* WIFI_SSID = "YourSSID";
+const char* WIFI_PASS = "YourPassword";
+
+#define WIFI_CONNECT_TIMEOUT_MS  15000    // one attempt, then back off
+#define WIFI_BACKOFF_MIN_MS      2000
+#define WIFI_BACKOFF_MAX_MS      300000UL
+
+// ---------- WiFi connection manager ----------
+// Never waits for the AP. The driver's events flip `up`; poll(), called
+// from the network task, starts an attempt, abandons it after
+// WIFI_CONNECT_TIMEOUT_MS and retries with backoff. The driver's own
+// auto-reconnect is off so the backoff is the only retry policy.
+class WifiManager {
+public:
+  std::atomic<bool> up{false};
+  uint32_t          connects = 0, drops = 0;
+
+  void begin() {
+    logger.add(logSrc);
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(false);
+    WiFi.onEvent(onEvent);
+    connect();
+  }
+
+  void poll() {
+    if (up) {
+      if (!wasUp) {
+        wasUp = true;
+        connects++;
+        backoff.ok();
+        logger.info(logSrc, "✅ WiFi connected, %s", WiFi.localIP().toString().c_str());
+      }
+      return;
+    }
+    if (wasUp) {
+      wasUp = false;
+      drops++;
+      attempting = false;
+      logger.warn(logSrc, "⚠️ WiFi lost, running offline");
+    }
+    if (attempting) {
+      if (millis() - attemptAt < WIFI_CONNECT_TIMEOUT_MS) return;
+      attempting = false;
+      WiFi.disconnect();
+      backoff.fail();
+      logger.warn(logSrc, "⚠️ WiFi connect timed out, retry in %lu s", backoff.delayMs / 1000);
+    }
+    if (backoff.ready()) connect();
+  }
+
+private:
+  Backoff       backoff{WIFI_BACKOFF_MIN_MS, WIFI_BACKOFF_MAX_MS};
+  LogSource     logSrc{"wifi"};
+  bool          wasUp = false, attempting = false;
+  unsigned long attemptAt = 0;
+
+  void connect() {
+    logger.info(logSrc, "Connecting to %s ...", WIFI_SSID);
+    WiFi.begin(WIFI_SSID, WIFI_PASS);
+    attempting = true;
+    attemptAt = millis();
+  }
+
+  static void onEvent(WiFiEvent_t event);
+};
+
+WifiManager wifi;
+
+// Runs in the WiFi driver's event task; only touches the atomic.
+void WifiManager::onEvent(WiFiEvent_t event) {
+  if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) wifi.up = true;
+  else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED || event == ARDUINO_EVENT_WIFI_STA_LOST_IP) wifi.up = false;
+}
+
+#endif
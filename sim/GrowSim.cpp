@@ -0,0 +1,379 @@
+// ---------- Grow Controller host simulator ----------
+// Runs the unchanged room controllers against the host HAL (sim/hal), a plant
+// model and a virtual clock, so weeks of grow cycles finish in seconds.
+//
+// Build (from the repo root):
+//   g++ -std=c++17 -O2 -Isim/hal -IGrow_Controller sim/GrowSim.cpp -o growsim
+// Run:
+//   ./growsim [days] [--trace relays.csv] [--verbose] [--perf] [--no-clock]
+//             [--pid] [--tune] [--humctl 0|1|2] [--http port] [--mqtt host:port]
+//             [--power]
+//
+// The virtual clock starts at local midnight with the wall clock set, as
+// after an SNTP sync; --no-clock runs the schedules on uptime instead.
+// --pid runs both rooms on the PID climate controller with the default
+// gains; --tune auto-tunes each room first, then carries on under PID.
+// --humctl overrides the humidity mode (0 off, 1 RH, 2 VPD) for both rooms.
+// --http serves the dashboard (Dashboard.h) on the given port and paces
+// the virtual clock to real time, so the page and its REST calls can be
+// tried against the simulated rooms; the console runs as in the firmware.
+// --mqtt publishes the MQTT batches (MqttReporter.h) to a broker, e.g. a
+// local mosquitto, also in real time. Stop the broker to watch batches
+// spool to the (RAM) flash ring and replay once it is back; commands on
+// grow/<device>/cmd are answered on grow/<device>/reply.
+// --power runs the power-save settings (Power.h): one-shot soil reads and
+// the slow console poll; the report shows how often the control loop woke.
+//
+// Note: unsigned long is 64-bit on Linux, so millis() wrap at ~49.7 days
+// is only reproduced when built with -m32.
+
+#include <Arduino.h>
+#include <chrono>
+#include <thread>
+#include "Rooms.h"
+#include "Scheduler.h"
+#include "PlantModel.h"
+#include "RelayTrace.h"
+#include "ClimateSensor.h"
+#include "SimAht20.h"
+#include "Console.h"
+#include "Dashboard.h"
+#include "MqttReporter.h"
+
+Preferences prefs;
+ConfigStore configStore;   // only touched by auto-tune, never loaded
+SoilSensors soilSensors;
+SoilCalibration soilCal;   // never loaded: probes run on the default curve
+
+VegRoom vegRoom;
+FlowerRoom flowerRoom;
+Room *const rooms[ROOM_COUNT] = { &vegRoom, &flowerRoom };
+Scheduler scheduler;
+TimerWheel timerWheel;
+IrrigationScheduler irrigation;
+PerfRegistry perf;
+Logger logger;
+SpscQueue<AlertMsg, 8> alertQueue;   // alerts are counted, the log already shows them
+
+// Console, dashboard and MQTT plumbing; Telegram and OTA have no host side
+SpscQueue<CommandMsg, 8> commandQueue;
+SpscQueue<ReplyMsg, 4>   replyQueue;
+SpscQueue<Telemetry, 2>  webTelemetryQueue;
+SpscQueue<CommandMsg, 4> webCommandQueue;
+SpscQueue<ReplyMsg, 4>   webReplyQueue;
+SpscQueue<Telemetry, 4>  mqttTelemetryQueue;
+SpscQueue<CommandMsg, 4> mqttCommandQueue;
+SpscQueue<ReplyMsg, 4>   mqttReplyQueue;
+std::atomic<bool> otaRequested{false};
+std::atomic<bool> netTaskRunning{false};
+History history;
+ResumeImage resumeRtc;
+ResumeStore resumeStore;
+Dashboard dashboard;
+MqttReporter mqttReporter;
+PowerManager power;
+PowerTask powerControl;
+
+RoomModel vegModel, flowerModel;
+RelayTrace trace;
+
+// One emulated AHT20 per room, each on its own bus as in the firmware
+SimAht20 vegAhtDev(vegModel), flowerAhtDev(flowerModel);
+Aht20 vegAht(Wire), flowerAht(Wire1);
+uint32_t noiseSeed = 1;
+
+// Same periods as the firmware task table
+#define SENSOR_PERIOD_MS     100
+#define CLIMATE_PERIOD_MS   2000
+#define ADC_PERIOD_MS        100
+#define SOIL_PERIOD_MS      1000
+#define FLOOD_PERIOD_MS      100
+#define LIGHT_PERIOD_MS     1000
+#define STATUS_PERIOD_MS    5000
+#define CONSOLE_PERIOD_MS     20
+#define TELEMETRY_PERIOD_MS 1000
+
+// ---------- Climate statistics (time weighted) ----------
+struct ClimateStats {
+  double seconds = 0, tempSum = 0, humSum = 0, inBand = 0, errSum = 0;
+  double vpdSum = 0, vpdInBand = 0;
+  float  tMin = 1e9, tMax = -1e9;
+
+  void add(const RoomModel &m, const Room &r, double dt) {
+    const RoomConfig &cfg = r.cfg;
+    int32_t airMc = milliC(m.temp);
+    float vpd = vpdPa(airMc, airMc + (r.lightState ? milliC(VPD_LEAF_OFFSET) : 0), lroundf(m.hum * 10)) / 1000.0f;
+    vpdSum  += vpd * dt;
+    if (fabsf(vpd - cfg.vpdTarget) <= cfg.vpdThreshold) vpdInBand += dt;
+    seconds += dt;
+    tempSum += m.temp * dt;
+    humSum  += m.hum * dt;
+    errSum  += fabsf(m.temp - cfg.idealTemp) * dt;
+    if (fabsf(m.temp - cfg.idealTemp) <= cfg.tempThreshold) inBand += dt;
+    if (m.temp < tMin) tMin = m.temp;
+    if (m.temp > tMax) tMax = m.temp;
+  }
+};
+
+ClimateStats vegStats, flowerStats;
+
+void stepModels(uint64_t fromUs, uint64_t toUs) {
+  float ambT, ambRH;
+  ambientAt(fromUs, ambT, ambRH);
+  double dt = (toUs - fromUs) / 1e6;
+  vegModel.step(dt, ambT, ambRH);
+  flowerModel.step(dt, ambT, ambRH);
+  vegStats.add(vegModel, vegRoom, dt);
+  flowerStats.add(flowerModel, flowerRoom, dt);
+}
+
+// ---------- Tasks (mirror Grow_Controller.ino) ----------
+void taskSensor()   { vegAht.poll(); flowerAht.poll(); }
+void taskClimate() {
+  float t, h;
+  for (Room *r : rooms) {
+    bool ok = r->climate.read(t, h);
+    r->checkSensor(ok);
+    if (ok) r->controlEnvironment(t, h);
+    else if (r->sensorAlarm) r->scheduleOnlyClimate();
+  }
+}
+void taskAdc()      { vegModel.publish(noiseSeed); flowerModel.publish(noiseSeed); soilSensors.poll(); }
+void taskSoil()     { for (Room *r : rooms) r->sampleSoil(); }
+void taskFlood()    { for (Room *r : rooms) r->manageWatering(); irrigation.poll(); }
+void taskLighting() { for (Room *r : rooms) r->handleLighting(); }
+void taskWheel()    { timerWheel.tick(millis64()); }
+void taskStatus()   { for (Room *r : rooms) r->printStatus(); }
+void taskConsole()  { handleSerial(); }
+
+void taskTelemetry() {
+  Telemetry t;
+  float temp, hum;
+  t.stamp     = millis();
+  t.roomCount = ROOM_COUNT;
+  for (uint8_t i = 0; i < ROOM_COUNT; i++) {
+    Room *r = rooms[i];
+    RoomTelemetry &rt = t.rooms[i];
+    rt.sensorOk = r->climate.read(temp, hum);
+    rt.temp     = r->lastTemp;
+    rt.hum      = r->lastHum;
+    rt.relays   = r->relays.states();
+    rt.floods   = 0;
+    for (uint8_t z = 0; z < r->zoneCount(); z++) {
+      rt.soil[z] = r->zoneSoil(z);
+      if (r->zoneWatering(z)) rt.floods |= 1 << z;
+    }
+  }
+  webTelemetryQueue.push(t);
+  mqttTelemetryQueue.push(t);
+}
+
+void setupModels() {
+  RelayController &vr = vegRoom.relays;
+  vegModel.heaterPin  = vr.pin(RELAY_HEATER);
+  vegModel.exhaustPin = vr.pin(RELAY_EXHAUST);
+  vegModel.lightPin   = vr.pin(RELAY_LIGHT);
+  for (int i = 0; i < 4; i++) vegModel.addProbe(vegRoom.def.soilPins[i], vr.pin(RELAY_WATER), 2100, i * 15 - 20);
+  vegModel.addProbe(vegRoom.def.soilPins[4], vr.pin(RELAY_INTAKE), 2200);   // mother zone
+
+  RelayController &fr = flowerRoom.relays;
+  flowerModel.heaterPin  = fr.pin(RELAY_HEATER);
+  flowerModel.exhaustPin = fr.pin(RELAY_EXHAUST);
+  flowerModel.lightPin   = fr.pin(RELAY_LIGHT);
+  flowerModel.intakePin  = fr.pin(RELAY_INTAKE);
+  for (int i = 0; i < 4; i++) flowerModel.addProbe(flowerRoom.def.soilPins[i], fr.pin(RELAY_WATER), 2300, i * 10 - 15);
+
+  host::onAdvance  = stepModels;
+  host::onPinWrite = [](int pin, int level) { trace.record(pin, level); };
+
+  Wire.device  = &vegAhtDev;
+  Wire1.device = &flowerAhtDev;
+}
+
+void printClimate(const char *name, const ClimateStats &s) {
+  printf("  %-7s temp avg %.1f°C  min %.1f  max %.1f  |err| %.2f  in-band %.1f%%\n",
+         name, s.tempSum / s.seconds, s.tMin, s.tMax, s.errSum / s.seconds, 100.0 * s.inBand / s.seconds);
+  printf("  %-7s hum avg %.1f%%  VPD avg %.2f kPa  in-band %.1f%%\n",
+         "", s.humSum / s.seconds, s.vpdSum / s.seconds, 100.0 * s.vpdInBand / s.seconds);
+}
+
+void printRelay(const char *name, int pin, double days) {
+  unsigned long n = trace.switchesOn(pin);
+  double hours = trace.onHours(pin);
+  printf("  %-16s %6.1f cycles/day  %6.2f h on/day", name, n / days, hours / days);
+  if (n) printf("  avg run %.1f s", hours * 3600.0 / n);
+  printf("\n");
+}
+
+int main(int argc, char **argv) {
+  double days = 63;   // 9-week 12/12 flower cycle
+  const char *tracePath = nullptr;
+  bool verbose = false, showPerf = false, wallClock = true, usePid = false, tune = false, powerSave = false;
+  int humctl = -1, httpPort = 0;
+  char mqttHost[64] = "";
+  uint16_t mqttPort = MQTT_PORT;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--trace") && i + 1 < argc) tracePath = argv[++i];
+    else if (!strcmp(argv[i], "--verbose")) verbose = true;
+    else if (!strcmp(argv[i], "--perf")) showPerf = true;
+    else if (!strcmp(argv[i], "--no-clock")) wallClock = false;
+    else if (!strcmp(argv[i], "--pid")) usePid = true;
+    else if (!strcmp(argv[i], "--tune")) tune = true;
+    else if (!strcmp(argv[i], "--power")) powerSave = true;
+    else if (!strcmp(argv[i], "--humctl") && i + 1 < argc) humctl = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--http") && i + 1 < argc) httpPort = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--mqtt") && i + 1 < argc) {
+      snprintf(mqttHost, sizeof(mqttHost), "%s", argv[++i]);
+      char *colon = strchr(mqttHost, ':');
+      if (colon) { *colon = '\0'; mqttPort = atoi(colon + 1); }
+    }
+    else days = atof(argv[i]);
+  }
+
+  host::serialEcho = verbose;
+  if (wallClock) host::wallEpochMs = 20454ULL * 86400000ULL;   // 2026-01-01 00:00
+  trace.keepEvents = tracePath != nullptr;
+
+  setupModels();
+  for (Room *r : rooms) r->begin();
+  for (Room *r : rooms) {
+    if (usePid) r->cfg.climateMode = CLIMATE_PID;
+    if (humctl >= 0) r->cfg.humidityMode = humctl;
+    if (tune) r->startAutotune();
+  }
+  power.add(powerControl, "control");
+  power.begin(powerSave);
+  soilSensors.begin(!power.enabled);
+  vegAht.begin();
+  flowerAht.begin();
+  vegRoom.climate.bind(&vegAht);
+  flowerRoom.climate.bind(&flowerAht);
+  vegModel.publish(noiseSeed);
+  flowerModel.publish(noiseSeed);
+
+  scheduler.add("sensor",   taskSensor,   SENSOR_PERIOD_MS);
+  scheduler.add("adc",      taskAdc,      ADC_PERIOD_MS);
+  scheduler.add("soil",     taskSoil,     SOIL_PERIOD_MS);
+  scheduler.add("climate",  taskClimate,  CLIMATE_PERIOD_MS);
+  scheduler.add("flood",    taskFlood,    FLOOD_PERIOD_MS);
+  scheduler.add("lighting", taskLighting, LIGHT_PERIOD_MS);
+  scheduler.add("wheel",    taskWheel,    WHEEL_TICK_MS);
+  scheduler.add("status",   taskStatus,   STATUS_PERIOD_MS, 500);
+  if (httpPort) {
+    if (!dashboard.begin(httpPort)) { fprintf(stderr, "Cannot listen on port %d\n", httpPort); return 1; }
+    printf("Dashboard on http://localhost:%d/ (real time, Ctrl-C to stop)\n", httpPort);
+  }
+  if (*mqttHost) {
+    mqttReporter.begin(mqttHost, mqttPort);
+    printf("MQTT to %s:%u as grow/%s (real time, Ctrl-C to stop)\n", mqttHost, mqttPort, MQTT_DEVICE);
+  }
+  const bool realTime = httpPort || *mqttHost;
+  if (realTime) {
+    fflush(stdout);
+    scheduler.add("console",   taskConsole,   power.period(CONSOLE_PERIOD_MS, POWER_CONSOLE_MS));
+    scheduler.add("telemetry", taskTelemetry, TELEMETRY_PERIOD_MS);
+  }
+
+  const uint64_t endUs = (uint64_t)(days * 86400e6);
+  unsigned long long passes = 0, alerts = 0;
+  std::chrono::nanoseconds busy(0);
+  auto wallStart = std::chrono::steady_clock::now();
+
+  while (host::nowUs < endUs) {
+    auto t0 = std::chrono::steady_clock::now();
+    unsigned long wait = scheduler.runDue();
+    busy += std::chrono::steady_clock::now() - t0;
+    logger.drain(Serial);   // the firmware's drain task
+    AlertMsg alert;
+    while (alertQueue.pop(alert)) alerts++;
+    passes++;
+    // the web and MQTT tasks sleep in select(), in real time; one of them
+    // paces the loop
+    bool paced = false;
+    if (httpPort) { dashboard.poll(wait); paced = true; }
+    if (*mqttHost) paced |= mqttReporter.poll(paced ? 0 : wait, true);
+    powerControl.asleep();
+    if (realTime && !paced) std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+    delay(wait ? wait : 1);
+    powerControl.awake();
+  }
+
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  trace.finish();
+
+  printf("Simulated %.1f days in %.2f s (%.0fx real time)\n", days, wall, days * 86400.0 / wall);
+  printf("Scheduler passes: %llu  avg cost %.0f ns/pass\n",
+         passes, passes ? (double)busy.count() / passes : 0.0);
+
+  printf("Chat alerts: %llu\n", alerts);
+  printf("Climate:\n");
+  printClimate("veg", vegStats);
+  printClimate("flower", flowerStats);
+
+  printf("Relays:\n");
+  printRelay("veg heater",     vegRoom.relays.pin(RELAY_HEATER),        days);
+  printRelay("veg exhaust",    vegRoom.relays.pin(RELAY_EXHAUST),       days);
+  printRelay("veg light",      vegRoom.relays.pin(RELAY_LIGHT),         days);
+  printRelay("veg pump",       vegRoom.relays.pin(RELAY_WATER),         days);
+  printRelay("mother valve",   vegRoom.relays.pin(RELAY_INTAKE),        days);
+  printRelay("flower heater",  flowerRoom.relays.pin(RELAY_HEATER),     days);
+  printRelay("flower exhaust", flowerRoom.relays.pin(RELAY_EXHAUST),    days);
+  printRelay("flower light",   flowerRoom.relays.pin(RELAY_LIGHT),      days);
+  printRelay("flower intake",  flowerRoom.relays.pin(RELAY_INTAKE),     days);
+  printRelay("flower pump",    flowerRoom.relays.pin(RELAY_WATER),      days);
+
+  printf("Flood queue: peak %u at once, %u mA (limits %u, %u mA)\n", irrigation.peakRunning(),
+         irrigation.peakCurrent(), IRR_MAX_ACTIVE, IRR_SUPPLY_MA);
+  for (uint8_t i = 0; i < irrigation.statCount(); i++) {
+    const FloodWaitStats &s = irrigation.stat(i);
+    printf("  %-7s %4u floods  wait avg %6.1f s  max %6.1f s  past deadline %u\n", s.name, s.grants,
+           s.totalWaitMs / 1000.0 / s.grants, s.maxWaitMs / 1000.0, s.late);
+  }
+
+  if (httpPort) {
+    const HttpServer &web = dashboard.server;
+    printf("Dashboard: %lu requests, %lu frames pushed, %lu skipped, %lu refused, pool exhausted %lu\n",
+           (unsigned long)web.requests, (unsigned long)web.wsFrames, (unsigned long)web.wsSkipped,
+           (unsigned long)web.rejected, (unsigned long)web.pool.exhausted);
+  }
+
+  if (*mqttHost) {
+    const MqttClient &c = mqttReporter.client;
+    printf("MQTT: %lu batches, %lu sent live, %lu replayed, %lu waiting, %lu lost, %lu dropped by the spool\n",
+           (unsigned long)mqttReporter.sealed, (unsigned long)mqttReporter.sentLive,
+           (unsigned long)mqttReporter.replayed, (unsigned long)mqttReporter.spool.pending(),
+           (unsigned long)mqttReporter.lost, (unsigned long)mqttReporter.spool.dropped);
+    printf("      %lu connects, %lu drops, %lu commands\n", (unsigned long)c.connects, (unsigned long)c.drops,
+           (unsigned long)mqttReporter.commands);
+  }
+
+  if (powerSave) {
+    const PowerTask &c = power.task(0);
+    printf("Power save: control loop woke %.1f times/s (virtual), soil read one-shot\n", c.wakes / power.seconds());
+  }
+
+  if (usePid || tune) {
+    printf("PID gains (kp %%/°C, ki %%/°C·min, kd %%·min/°C):\n");
+    for (Room *r : rooms)
+      printf("  %-7s kp %.1f  ki %.3f  kd %.1f\n", r->name(), r->cfg.pidKp, r->cfg.pidKi, r->cfg.pidKd);
+  }
+
+  if (showPerf) {
+    // host ns stand in for cycles, lateness is on the virtual clock
+    printf("Stages (µs):\n");
+    for (uint8_t i = 0; i < perf.size(); i++) {
+      const PerfStat &s = perf.stat(i);
+      if (!s.runs) continue;
+      printf("  %-16s %9u runs  avg %6.2f  p99 %5u  max %6u  late p99 %5u  missed %u\n",
+             s.name, s.runs, (double)s.totalUs / s.runs, s.p99(), s.maxUs,
+             s.late.percentile(s.runs, 99), s.missed);
+    }
+  }
+
+  if (tracePath) {
+    if (trace.writeCsv(tracePath)) printf("Relay trace written to %s (%zu events)\n", tracePath, trace.events.size());
+    else printf("Could not write %s\n", tracePath);
+  }
+  return 0;
+}
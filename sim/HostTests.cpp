@@ -0,0 +1,229 @@
+// ---------- Host tests ----------
+// Focused checks of controller logic on the host HAL, for behaviour the
+// simulator's averages would not show.
+//
+// Build and run (from the repo root):
+//   g++ -std=c++17 -O2 -Wall -Isim/hal -IGrow_Controller sim/HostTests.cpp -o hosttests && ./hosttests
+// Exit status is the number of failed checks.
+
+#include <Arduino.h>
+#include "Rooms.h"
+#include "Console.h"
+#include "MqttReporter.h"
+
+// What the console needs of the sketch's globals
+Preferences prefs;
+ConfigStore configStore;
+SoilSensors soilSensors;
+SoilCalibration soilCal;
+VegRoom vegRoom;
+FlowerRoom flowerRoom;
+Room *const rooms[ROOM_COUNT] = { &vegRoom, &flowerRoom };
+TimerWheel timerWheel;
+IrrigationScheduler irrigation;
+PerfRegistry perf;
+Logger logger;
+History history;
+ResumeStore resumeStore;
+ResumeImage resumeRtc;
+PowerManager power;
+SpscQueue<AlertMsg, 8>   alertQueue;
+SpscQueue<CommandMsg, 8> commandQueue;
+SpscQueue<ReplyMsg, 4>   replyQueue;
+SpscQueue<CommandMsg, 4> webCommandQueue;
+SpscQueue<ReplyMsg, 4>   webReplyQueue;
+SpscQueue<CommandMsg, 4> mqttCommandQueue;
+SpscQueue<ReplyMsg, 4>   mqttReplyQueue;
+SpscQueue<Telemetry, 4>  mqttTelemetryQueue;
+std::atomic<bool> otaRequested{false};
+std::atomic<bool> netTaskRunning{false};
+
+static int failures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+      failures++;                                                     \
+    }                                                                 \
+  } while (0)
+
+// ---------- Irrigation ----------
+static uint8_t lastGranted = 0xFF;
+
+static bool grant(void *, uint8_t zone) {
+  lastGranted = zone;
+  return true;
+}
+
+static FloodRequest request(uint8_t zone, int32_t priority, uint16_t ma, uint32_t deadlineS) {
+  uint64_t now = millis64();
+  FloodRequest r = { grant, nullptr, zone, "zone", priority, 30000, ma, now, now + deadlineS * 1000ULL };
+  return r;
+}
+
+// An overdue request goes before a drier one that is still on time, even
+// when no other queue change happens in between
+static void testOverdueFirst() {
+  IrrigationScheduler irr;
+  irr.submit(request(0, 100, IRR_SUPPLY_MA, 600));   // X takes the whole supply
+  irr.poll();
+  CHECK(lastGranted == 0);
+
+  irr.submit(request(1, 10, IRR_SUPPLY_MA, 10));     // A: slightly dry, 10 s deadline
+  irr.submit(request(2, 500, IRR_SUPPLY_MA, 600));   // B: much drier, on time for 10 min
+  delay(20000);
+  irr.poll();                                        // supply still busy
+  CHECK(irr.size() == 2);
+
+  irr.release(nullptr, 0);
+  irr.poll();
+  CHECK(lastGranted == 1);
+  CHECK(irr.size() == 1);
+}
+
+// ---------- Flash spool ----------
+#define SPOOL_TEST_LEN  2000   // two records to a sector
+
+static const char *payload(uint32_t seq) {
+  static char data[SPOOL_TEST_LEN];
+  memset(data, 'a' + seq % 26, sizeof(data));
+  return data;
+}
+
+// Deliver records up to and including seq upTo; each must be the next one
+static void deliver(Spool &s, uint32_t &seq, uint32_t upTo) {
+  static char buf[SPOOL_TEST_LEN];
+  for (; seq <= upTo; seq++) {
+    uint32_t got = 0;
+    size_t n = s.peek(buf, sizeof(buf), got);
+    bool ok = n == sizeof(buf) && got == seq && !memcmp(buf, payload(seq), n);
+    CHECK(ok);
+    if (!ok) return;
+    s.markSent();
+  }
+}
+
+// Wrap the ring with records still waiting, reset mid-replay, and
+// deliver the rest across the wrap, oldest first
+static void testSpool() {
+  Spool s;
+  CHECK(s.begin());
+  CHECK(s.pending() == 0 && s.lastSeq() == 0);
+  uint32_t seq = 1, perWrap = s.bytes() / HAL_SPOOL_SECTOR * 2;
+  for (uint32_t i = 1; i <= 10; i++) CHECK(s.append(i, payload(i), SPOOL_TEST_LEN));
+  deliver(s, seq, 10);
+  CHECK(s.pending() == 0);
+
+  uint32_t last = 10 + perWrap + 5;   // the writer erases sectors still holding live records
+  for (uint32_t i = 11; i <= last; i++) CHECK(s.append(i, payload(i), SPOOL_TEST_LEN));
+  CHECK(s.dropped > 0);
+  CHECK(s.pending() == last - 10 - s.dropped);
+  seq = 11 + s.dropped;                // the oldest survivor
+  deliver(s, seq, seq + 19);
+
+  Spool again;                         // reset: rebuild from flash
+  CHECK(again.begin());
+  CHECK(again.lastSeq() == last);
+  CHECK(again.pending() == last - seq + 1);
+  deliver(again, seq, last);           // crosses the end of the ring
+  uint32_t none;
+  CHECK(again.pending() == 0);
+  CHECK(again.peek(nullptr, 0, none) == 0);
+
+  Spool third;
+  CHECK(third.begin());
+  CHECK(third.pending() == 0 && third.lastSeq() == last);
+  CHECK(third.append(last + 1, payload(last + 1), SPOOL_TEST_LEN));
+  deliver(third, seq, last + 1);
+}
+
+// ---------- MQTT batch seq ----------
+// Seal whatever is due and open a new batch; its seq
+static uint32_t openBatch(MqttReporter &r) {
+  delay(MQTT_BATCH_MS);
+  r.poll(0, false);
+  Telemetry t = {};
+  t.stamp = millis();
+  t.roomCount = ROOM_COUNT;
+  mqttTelemetryQueue.push(t);
+  r.poll(0, false);
+  return r.lastSeq();
+}
+
+// A batch that never reached the spool (published live from RAM, or
+// still open) keeps its seq after a reset, past a reserved block too
+static void testSeqAcrossReset() {
+  static MqttReporter before, after, later;   // the logger keeps their sources
+  before.begin("127.0.0.1", 1);
+  uint32_t seq = 0;
+  for (int i = 0; i < MQTT_SEQ_BLOCK + 2; i++) seq = openBatch(before);
+  CHECK(before.spool.lastSeq() < seq);   // the open batch is in RAM only
+
+  after.begin("127.0.0.1", 1);
+  uint32_t next = openBatch(after);
+  CHECK(next > seq);
+  later.begin("127.0.0.1", 1);
+  CHECK(openBatch(later) > next);
+}
+
+// ---------- Console ----------
+// Run one command line, return its reply
+static const char *run(const char *line) {
+  static ReplyBuffer reply;
+  char buf[CMD_LINE_MAX];
+  snprintf(buf, sizeof(buf), "%s", line);
+  reply = ReplyBuffer();
+  runCommand(buf, reply);
+  return reply.msg.text;
+}
+
+static bool accepted(const char *line) { return strstr(run(line), "✅") != nullptr; }
+
+// `set` keeps RoomConfig inside each parameter's range
+static void testSetLimits() {
+  const RoomConfig &cfg = vegRoom.cfg;
+  CHECK(accepted("set veg pid 1"));
+  CHECK(cfg.climateMode == CLIMATE_PID);
+  CHECK(!accepted("set veg pid 7"));
+  CHECK(!accepted("set veg pid 0.5"));
+  CHECK(cfg.climateMode == CLIMATE_PID);
+  CHECK(accepted("set veg humctl 2"));
+  CHECK(!accepted("set veg humctl 9"));
+  CHECK(cfg.humidityMode == HUMIDITY_VPD);
+
+  float th = cfg.tempThreshold;
+  CHECK(!accepted("set veg tempth -1"));
+  CHECK(!accepted("set veg tempth nan"));
+  CHECK(!accepted("set veg temp inf"));
+  CHECK(!accepted("set veg lighton 25"));
+  CHECK(cfg.tempThreshold == th);
+  CHECK(accepted("set veg tempth 0.5"));
+  CHECK(cfg.tempThreshold == 0.5f);
+}
+
+// Soil settings are %, an old-style count is refused with the unit shown
+static void testSoilPercent() {
+  const RoomConfig &cfg = vegRoom.cfg;
+  float target = cfg.idealSoil;
+  const char *reply = run("set veg soil 2100");
+  CHECK(!strstr(reply, "✅"));
+  CHECK(strstr(reply, "%") != nullptr);
+  CHECK(cfg.idealSoil == target);
+  CHECK(!accepted("set veg soilth 200"));
+  CHECK(!accepted("set veg soil -5"));
+  CHECK(accepted("set veg soil 45"));
+  CHECK(cfg.idealSoil == 45);
+}
+
+int main() {
+  vegRoom.begin();
+  flowerRoom.begin();
+  testOverdueFirst();
+  testSpool();
+  testSeqAcrossReset();
+  testSetLimits();
+  testSoilPercent();
+  printf("%s (%d failed)\n", failures ? "FAILED" : "All host tests passed", failures);
+  return failures;
+}
@@ -0,0 +1,102 @@
+#ifndef PLANTMODEL_H
+#define PLANTMODEL_H
+
+#include <Arduino.h>
+
+// ---------- Simple room plant model ----------
+// First-order thermal and humidity response to heater, exhaust, intake and lights,
+// plus per-probe soil moisture that dries over time and rises while the
+// zone's feed relay (pump or solenoid) is energised. Soil is expressed in
+// raw ADC counts, higher = wetter, matching the controller's thresholds.
+
+struct SoilProbe {
+  int   pin;
+  int   feedPin;      // relay that floods this probe's zone
+  float level;        // ADC counts
+  float offset;       // fixed per-probe bias
+};
+
+class RoomModel {
+public:
+  static const int MAX_PROBES = 6;
+
+  // actuators (relay pins, -1 if absent)
+  int heaterPin = -1, exhaustPin = -1, lightPin = -1, intakePin = -1;
+
+  // state
+  float temp = 22.0, hum = 60.0;
+  SoilProbe probes[MAX_PROBES];
+  int probeCount = 0;
+
+  // tuning, per hour unless noted
+  float leakTauH     = 2.0;    // envelope time constant
+  float exhaustTauH  = 0.25;   // exhaust pulls toward ambient this fast
+  float intakeTauH   = 0.5;    // an intake fan adds to the exchange
+  float heaterRate   = 8.0;    // °C/h
+  float lightHeat    = 2.5;    // °C/h from lamps
+  float transpRate   = 8.0;    // %RH/h while lit
+  float dryRateLit   = 60.0;   // counts/h
+  float dryRateDark  = 25.0;   // counts/h
+  float floodRate    = 20.0;   // counts/s while the feed relay is on
+  float soilMin = 1000, soilMax = 3200;
+
+  void addProbe(int pin, int feedPin, float level, float offset = 0) {
+    if (probeCount < MAX_PROBES) probes[probeCount++] = { pin, feedPin, level, offset };
+  }
+
+  void step(float dtSec, float ambientT, float ambientRH) {
+    float h = dtSec / 3600.0f;
+    bool heater  = on(heaterPin);
+    bool exhaust = on(exhaustPin);
+    bool light   = on(lightPin);
+    bool intake  = on(intakePin);
+
+    float dT = (ambientT - temp) / leakTauH;
+    if (heater)  dT += heaterRate;
+    if (light)   dT += lightHeat;
+    if (exhaust) dT += (ambientT - temp) / exhaustTauH;
+    if (intake)  dT += (ambientT - temp) / intakeTauH;
+    temp += dT * h;
+
+    float dH = (ambientRH - hum) / leakTauH;
+    if (light)   dH += transpRate;
+    if (exhaust) dH += (ambientRH - hum) / exhaustTauH;
+    if (intake)  dH += (ambientRH - hum) / intakeTauH;
+    hum = constrain(hum + dH * h, 5.0f, 99.0f);
+
+    for (int i = 0; i < probeCount; i++) {
+      SoilProbe &p = probes[i];
+      p.level -= (light ? dryRateLit : dryRateDark) * h;
+      if (on(p.feedPin)) p.level += floodRate * dtSec;
+      p.level = constrain(p.level, soilMin, soilMax);
+    }
+  }
+
+  float spikeChance = 0.005f;   // fraction of samples that read as a dry spike
+
+  // Publish probe levels to the host ADC with deterministic noise and the
+  // occasional single-sample spike a capacitive probe produces.
+  void publish(uint32_t &seed) const {
+    for (int i = 0; i < probeCount; i++) {
+      seed = seed * 1664525u + 1013904223u;
+      float noise = (float)((seed >> 16) % 41) - 20.0f;   // ±20 counts
+      float v = probes[i].level + probes[i].offset + noise;
+      if ((seed >> 8 & 0xFFFF) < spikeChance * 65536.0f) v = 300;
+      host::analogLevel[probes[i].pin] = (uint16_t)constrain(v, 0.0f, 4095.0f);
+    }
+  }
+
+private:
+  static bool on(int pin) { return pin >= 0 && digitalRead(pin) == HIGH; }
+  static float constrain(float v, float lo, float hi) { return v < lo ? lo : (v > hi ? hi : v); }
+};
+
+// Outdoor conditions: daily sinusoid, coldest around 03:00.
+inline void ambientAt(uint64_t us, float &t, float &rh) {
+  double day = (double)(us % 86400000000ULL) / 86400000000.0;
+  double s = sin(2.0 * M_PI * (day - 0.375));
+  t  = 20.0f + 5.0f * (float)s;
+  rh = 55.0f - 10.0f * (float)s;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef RELAYTRACE_H
+#define RELAYTRACE_H
+
+#include <Arduino.h>
+#include <vector>
+
+// ---------- Relay trace ----------
+// Records every output transition with its virtual timestamp and keeps
+// per-pin switch counts and on-time for the end-of-run summary.
+
+class RelayTrace {
+public:
+  struct Event { uint64_t us; uint8_t pin; uint8_t level; };
+
+  std::vector<Event> events;
+  bool keepEvents = false;
+
+  void record(int pin, int level) {
+    if (pin < 0 || pin >= host::NUM_PINS || host::pinMode_[pin] != OUTPUT) return;
+    if (level == last[pin]) return;
+    uint64_t now = host::nowUs;
+    if (last[pin] == HIGH) onUs[pin] += now - since[pin];
+    else if (level == HIGH) switches[pin]++;
+    last[pin] = level;
+    since[pin] = now;
+    if (keepEvents) events.push_back({ now, (uint8_t)pin, (uint8_t)level });
+  }
+
+  // Close open intervals so on-time covers the whole run.
+  void finish() {
+    for (int p = 0; p < host::NUM_PINS; p++)
+      if (last[p] == HIGH) { onUs[p] += host::nowUs - since[p]; since[p] = host::nowUs; }
+  }
+
+  unsigned long switchesOn(int pin) const { return switches[pin]; }
+  double onHours(int pin) const { return onUs[pin] / 3.6e9; }
+
+  bool writeCsv(const char *path) const {
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "seconds,pin,level\n");
+    for (const Event &e : events) fprintf(f, "%.3f,%u,%u\n", e.us / 1e6, e.pin, e.level);
+    fclose(f);
+    return true;
+  }
+
+private:
+  uint8_t       last[host::NUM_PINS]     = {};
+  uint64_t      since[host::NUM_PINS]    = {};
+  uint64_t      onUs[host::NUM_PINS]     = {};
+  unsigned long switches[host::NUM_PINS] = {};
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef SIMAHT20_H
+#define SIMAHT20_H
+
+#include <Wire.h>
+#include "PlantModel.h"
+
+// ---------- Emulated AHT20 ----------
+// Answers the real driver's I2C traffic with readings from a room model,
+// including the busy bit for the first 80 ms after a trigger.
+class SimAht20 : public host::I2cDevice {
+public:
+  explicit SimAht20(const RoomModel &room) : room(room) {}
+
+  bool write(uint8_t addr, const uint8_t *d, size_t n) override {
+    if (addr != 0x38) return false;
+    if (n >= 1 && d[0] == 0xAC) { triggerUs = host::nowUs; latch(); }
+    return true;
+  }
+
+  size_t read(uint8_t addr, uint8_t *d, size_t n) override {
+    if (addr != 0x38) return 0;
+    bool busy = host::nowUs - triggerUs < 80000;
+    uint8_t frame[7] = { (uint8_t)(0x08 | (busy ? 0x80 : 0)),
+                         (uint8_t)(rawH >> 12), (uint8_t)(rawH >> 4),
+                         (uint8_t)(((rawH & 0x0F) << 4) | (rawT >> 16)),
+                         (uint8_t)(rawT >> 8), (uint8_t)rawT, 0 };
+    frame[6] = crc8(frame, 6);
+    if (n > sizeof(frame)) n = sizeof(frame);
+    memcpy(d, frame, n);
+    return n;
+  }
+
+private:
+  const RoomModel &room;
+  uint64_t triggerUs = 0;
+  uint32_t rawH = 0, rawT = 0;
+
+  void latch() {
+    rawH = (uint32_t)(room.hum / 100.0f * 1048576.0f) & 0xFFFFF;
+    rawT = (uint32_t)((room.temp + 50.0f) / 200.0f * 1048576.0f) & 0xFFFFF;
+  }
+
+  static uint8_t crc8(const uint8_t *d, size_t n) {
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < n; i++) {
+      crc ^= d[i];
+      for (int b = 0; b < 8; b++) crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+    return crc;
+  }
+};
+
+#endif
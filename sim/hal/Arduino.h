@@ -0,0 +1,248 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// ---------- Host (Linux) backend for the Arduino API ----------
+// Lets the unchanged controller headers build natively. Time comes from a
+// virtual clock that only moves when delay() is called, pins are plain
+// arrays, and Serial writes to stdout when echo is enabled.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+
+#define HIGH   1
+#define LOW    0
+#define INPUT  0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define IRAM_ATTR
+#define RTC_NOINIT_ATTR
+
+typedef uint8_t byte;
+
+#define bit(b) (1UL << (b))
+using std::min;   // the ESP32 core exposes these unqualified
+using std::max;
+
+namespace host {
+  const int NUM_PINS = 40;
+
+  // Virtual clock (µs). Only delay() advances it.
+  inline uint64_t nowUs = 0;
+
+  // Called for every slice of virtual time, e.g. to step a plant model.
+  inline void (*onAdvance)(uint64_t fromUs, uint64_t toUs) = nullptr;
+  inline uint64_t advanceSliceUs = 1000000;   // model step granularity
+
+  // Pin state; analogLevel is what analogRead returns.
+  inline uint8_t  pinMode_[NUM_PINS]    = {};
+  inline uint8_t  pinLevel[NUM_PINS]    = {};
+  inline uint16_t analogLevel[NUM_PINS] = {};
+  inline void (*onPinWrite)(int pin, int level) = nullptr;
+
+  inline bool serialEcho = true;
+  inline std::string serialInput;             // bytes waiting to be "received"
+
+  // One-shot timers (esp_timer stand-ins); they fire at their exact
+  // virtual deadline while delay() advances the clock.
+  struct Timer {
+    void   (*cb)(void *);
+    void    *arg;
+    uint64_t dueUs;
+    bool     armed;
+  };
+  const int MAX_TIMERS = 16;
+  inline Timer timers[MAX_TIMERS];
+  inline int   timerCount = 0;
+
+  inline uint64_t nextTimerUs() {
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < timerCount; i++)
+      if (timers[i].armed && timers[i].dueUs < next) next = timers[i].dueUs;
+    return next;
+  }
+
+  inline void fireTimers() {
+    for (int i = 0; i < timerCount; i++)
+      if (timers[i].armed && timers[i].dueUs <= nowUs) {
+        timers[i].armed = false;
+        timers[i].cb(timers[i].arg);
+      }
+  }
+
+  inline void advanceUs(uint64_t us) {
+    uint64_t target = nowUs + us;
+    fireTimers();
+    while (nowUs < target) {
+      uint64_t step = target - nowUs;
+      if (step > advanceSliceUs) step = advanceSliceUs;
+      uint64_t due = nextTimerUs();
+      if (due > nowUs && due - nowUs < step) step = due - nowUs;
+      uint64_t from = nowUs;
+      nowUs += step;
+      if (onAdvance) onAdvance(from, nowUs);
+      fireTimers();
+    }
+  }
+}
+
+inline unsigned long millis() { return (unsigned long)(host::nowUs / 1000); }
+inline unsigned long micros() { return (unsigned long)host::nowUs; }
+inline void delay(unsigned long ms) { host::advanceUs((uint64_t)ms * 1000); }
+inline void delayMicroseconds(unsigned int us) { host::advanceUs(us); }
+inline void yield() {}
+
+inline void pinMode(int pin, int mode) {
+  if (pin >= 0 && pin < host::NUM_PINS) host::pinMode_[pin] = mode;
+}
+
+inline void digitalWrite(int pin, int level) {
+  if (pin < 0 || pin >= host::NUM_PINS) return;
+  host::pinLevel[pin] = level ? HIGH : LOW;
+  if (host::onPinWrite) host::onPinWrite(pin, level ? HIGH : LOW);
+}
+
+inline int digitalRead(int pin) {
+  return (pin >= 0 && pin < host::NUM_PINS) ? host::pinLevel[pin] : LOW;
+}
+
+inline int analogRead(int pin) {
+  return (pin >= 0 && pin < host::NUM_PINS) ? host::analogLevel[pin] : 0;
+}
+
+// ---------- String (subset used by the sketch) ----------
+class String {
+public:
+  String() {}
+  String(const char *c) : s(c ? c : "") {}
+  String(const std::string &str) : s(str) {}
+  String(char c) : s(1, c) {}
+  String(int v) : s(std::to_string(v)) {}
+  String(long v) : s(std::to_string(v)) {}
+  String(unsigned long v) : s(std::to_string(v)) {}
+  String(long long v) : s(std::to_string(v)) {}
+  String(double v, int decimals = 2) {
+    char b[48]; snprintf(b, sizeof(b), "%.*f", decimals, v); s = b;
+  }
+
+  const char *c_str() const { return s.c_str(); }
+  unsigned int length() const { return s.size(); }
+  char operator[](unsigned int i) const { return i < s.size() ? s[i] : 0; }
+
+  bool operator==(const String &o) const { return s == o.s; }
+  bool operator==(const char *o) const { return s == o; }
+  bool operator!=(const String &o) const { return s != o.s; }
+  String operator+(const String &o) const { return String(s + o.s); }
+  String &operator+=(const String &o) { s += o.s; return *this; }
+  String &operator+=(const char *o) { s += o; return *this; }
+  String &operator+=(char c) { s += c; return *this; }
+
+  bool equalsIgnoreCase(const String &o) const {
+    if (s.size() != o.s.size()) return false;
+    for (size_t i = 0; i < s.size(); i++)
+      if (tolower((unsigned char)s[i]) != tolower((unsigned char)o.s[i])) return false;
+    return true;
+  }
+  bool startsWith(const String &p) const { return s.compare(0, p.s.size(), p.s) == 0; }
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t i = s.find(c, from); return i == std::string::npos ? -1 : (int)i;
+  }
+  String substring(unsigned int from, unsigned int to = ~0u) const {
+    if (from > s.size()) return String();
+    if (to > s.size()) to = s.size();
+    return String(s.substr(from, to > from ? to - from : 0));
+  }
+  void remove(unsigned int index, unsigned int count = ~0u) {
+    if (index < s.size()) s.erase(index, count);
+  }
+  void trim() {
+    size_t b = s.find_first_not_of(" \t\r\n");
+    size_t e = s.find_last_not_of(" \t\r\n");
+    s = (b == std::string::npos) ? std::string() : s.substr(b, e - b + 1);
+  }
+  float toFloat() const { return strtof(s.c_str(), nullptr); }
+  long  toInt() const { return strtol(s.c_str(), nullptr, 10); }
+  void  reserve(unsigned int n) { s.reserve(n); }
+
+private:
+  std::string s;
+};
+
+inline String operator+(const char *a, const String &b) { return String(a) + b; }
+
+// ---------- Print / Serial ----------
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buf, size_t n) {
+    size_t w = 0;
+    while (n--) w += write(*buf++);
+    return w;
+  }
+  size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+
+  size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[256];
+    va_list ap; va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n <= 0) return 0;
+    return write((const uint8_t *)buf, (size_t)n < sizeof(buf) ? n : sizeof(buf) - 1);
+  }
+  size_t print(const String &v)     { return write(v.c_str()); }
+  size_t print(const char *v)       { return write(v); }
+  size_t print(char v)              { return write((uint8_t)v); }
+  size_t print(int v)               { return printf("%d", v); }
+  size_t print(long v)              { return printf("%ld", v); }
+  size_t print(unsigned int v)      { return printf("%u", v); }
+  size_t print(unsigned long v)     { return printf("%lu", v); }
+  size_t print(double v, int d = 2) { return printf("%.*f", d, v); }
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(const T &v) { return print(v) + println(); }
+};
+
+class HostSerial : public Print {
+public:
+  void begin(unsigned long) {}
+  void setTimeout(unsigned long) {}
+  void flush() { fflush(stdout); }
+
+  int available() { return (int)host::serialInput.size(); }
+  int read() {
+    if (host::serialInput.empty()) return -1;
+    int c = (unsigned char)host::serialInput[0];
+    host::serialInput.erase(0, 1);
+    return c;
+  }
+  String readStringUntil(char term) {
+    std::string out;
+    int c;
+    while ((c = read()) >= 0 && c != term) out += (char)c;
+    return String(out);
+  }
+
+  size_t write(uint8_t c) override { if (host::serialEcho && c != '\r') fputc(c, stdout); return 1; }
+  using Print::write;
+
+  operator bool() const { return true; }
+};
+
+inline HostSerial Serial;
+
+struct HostEsp {
+  void restart() { fflush(stdout); exit(0); }
+  uint32_t getFreeHeap() { return 0; }
+};
+
+inline HostEsp ESP;
+
+#endif
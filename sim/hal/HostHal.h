@@ -0,0 +1,150 @@
+#ifndef HOSTHAL_H
+#define HOSTHAL_H
+
+#include <Arduino.h>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+
+// ---------- Host versions of the Hal.h primitives ----------
+
+// Same instant for every pin; goes through digitalWrite so the relay
+// trace sees each transition.
+inline void gpioWriteMasks(uint64_t setPins, uint64_t clearPins) {
+  for (int p = 0; p < host::NUM_PINS; p++) {
+    if (setPins   & (1ULL << p)) digitalWrite(p, HIGH);
+    if (clearPins & (1ULL << p)) digitalWrite(p, LOW);
+  }
+}
+
+// ---------- One-shot timers and monotonic time ----------
+typedef int OneShotHandle;
+const OneShotHandle ONESHOT_NONE = -1;
+
+inline uint64_t halMicros64() { return host::nowUs; }
+inline uint64_t halRtcMicros() { return host::nowUs; }
+
+// Wall clock: unset until the simulator gives it an epoch
+namespace host {
+  inline uint64_t wallEpochMs = 0;   // local wall time at nowUs == 0
+}
+
+inline bool halWallMs(uint64_t &localMs) {
+  if (!host::wallEpochMs) return false;
+  localMs = host::wallEpochMs + host::nowUs / 1000;
+  return true;
+}
+
+inline OneShotHandle oneShotCreate(void (*cb)(void *), void *arg, const char *) {
+  if (host::timerCount >= host::MAX_TIMERS) return ONESHOT_NONE;
+  host::timers[host::timerCount] = { cb, arg, 0, false };
+  return host::timerCount++;
+}
+
+inline bool oneShotStart(OneShotHandle h, uint64_t us) {
+  if (h == ONESHOT_NONE) return false;
+  host::timers[h].dueUs = host::nowUs + us;
+  host::timers[h].armed = true;
+  return true;
+}
+
+inline void oneShotStop(OneShotHandle h) {
+  if (h != ONESHOT_NONE) host::timers[h].armed = false;
+}
+
+// ---------- Cycle counter ----------
+// Host nanoseconds stand in for CPU cycles, so simulator perf numbers are
+// real execution times on the build machine.
+inline uint32_t halCycles() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline uint32_t halCyclesPerUs() { return 1000; }
+
+// "DMA" stream: every read returns the current host ADC level of each pin.
+namespace host {
+  inline uint8_t adcStream[40];
+  inline size_t  adcStreamCount = 0;
+}
+
+inline bool adcStreamBegin(const uint8_t *pins, size_t n, uint32_t, uint32_t) {
+  host::adcStreamCount = n < 40 ? n : 40;
+  memcpy(host::adcStream, pins, host::adcStreamCount);
+  return true;
+}
+
+inline int adcStreamRead(uint8_t *pins, uint16_t *raw, int max) {
+  int n = 0;
+  for (size_t i = 0; i < host::adcStreamCount && n < max; i++) {
+    pins[n] = host::adcStream[i];
+    raw[n++] = analogRead(host::adcStream[i]);
+  }
+  return n;
+}
+
+// ---------- Sockets ----------
+// The system's BSD sockets; a peer that went away must not raise SIGPIPE.
+inline bool halSockNonBlocking(int fd) { return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) == 0; }
+inline int  halSockSend(int fd, const void *buf, size_t n) { return send(fd, buf, n, MSG_DONTWAIT | MSG_NOSIGNAL); }
+inline void halSockClose(int fd) { close(fd); }
+
+inline bool halResolve(const char *host, uint16_t port, struct sockaddr_in &out) {
+  struct addrinfo hints = {}, *res = nullptr;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  char service[6];
+  snprintf(service, sizeof(service), "%u", port);
+  if (getaddrinfo(host, service, &hints, &res) || !res) return false;
+  memcpy(&out, res->ai_addr, sizeof(out));
+  freeaddrinfo(res);
+  return true;
+}
+
+// ---------- Power ----------
+// No sleep on the host; a wait is a jump of the virtual clock.
+inline bool halPowerSave(uint16_t, uint16_t) { return true; }
+inline uint16_t halCpuMhz() { return 240; }
+inline void halSleepKeepPin(int) {}
+inline bool halSerialWake(uint8_t, void (*)()) { return true; }
+
+typedef void *HalTask;
+inline HalTask halCurrentTask() { return nullptr; }
+inline void halWaitWake(uint32_t ms) { delay(ms); }
+inline void halWakeTask(HalTask) {}
+
+// ---------- Spool flash ----------
+// RAM that behaves like NOR flash: erased to 0xFF a sector at a time,
+// writes can only clear bits. Lost when the simulator exits.
+#define HAL_SPOOL_SECTOR  4096
+
+namespace host {
+  inline uint8_t spoolFlash[512 * 1024];
+  inline bool    spoolFresh = true;   // power-on contents are unknown, start erased
+}
+
+inline uint32_t halSpoolSize() {
+  if (host::spoolFresh) { memset(host::spoolFlash, 0xFF, sizeof(host::spoolFlash)); host::spoolFresh = false; }
+  return sizeof(host::spoolFlash);
+}
+inline bool halSpoolErase(uint32_t off) {
+  if (off + HAL_SPOOL_SECTOR > sizeof(host::spoolFlash)) return false;
+  memset(host::spoolFlash + off, 0xFF, HAL_SPOOL_SECTOR);
+  return true;
+}
+inline bool halSpoolWrite(uint32_t off, const void *p, size_t n) {
+  if (off + n > sizeof(host::spoolFlash)) return false;
+  for (size_t i = 0; i < n; i++) host::spoolFlash[off + i] &= ((const uint8_t *)p)[i];
+  return true;
+}
+inline bool halSpoolRead(uint32_t off, void *p, size_t n) {
+  if (off + n > sizeof(host::spoolFlash)) return false;
+  memcpy(p, host::spoolFlash + off, n);
+  return true;
+}
+
+#endif
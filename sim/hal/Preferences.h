@@ -0,0 +1,62 @@
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+
+// In-memory NVS: namespaces and keys live for the life of the process.
+namespace host {
+  inline std::map<std::string, std::map<std::string, std::vector<uint8_t>>> nvs;
+}
+
+class Preferences {
+public:
+  bool begin(const char *name, bool readOnly = false) {
+    ns = name; ro = readOnly; return true;
+  }
+  void end() { ns.clear(); }
+
+  bool isKey(const char *key) { return table().count(key) > 0; }
+  bool remove(const char *key) { return !ro && table().erase(key) > 0; }
+  bool clear() { if (ro) return false; table().clear(); return true; }
+
+  size_t putBytes(const char *key, const void *buf, size_t len) {
+    if (ro) return 0;
+    const uint8_t *p = (const uint8_t *)buf;
+    table()[key].assign(p, p + len);
+    return len;
+  }
+  size_t getBytesLength(const char *key) {
+    auto it = table().find(key);
+    return it == table().end() ? 0 : it->second.size();
+  }
+  size_t getBytes(const char *key, void *buf, size_t maxLen) {
+    auto it = table().find(key);
+    if (it == table().end() || it->second.size() > maxLen) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+  }
+
+  size_t putFloat(const char *k, float v)          { return putBytes(k, &v, sizeof(v)); }
+  size_t putInt(const char *k, int32_t v)          { return putBytes(k, &v, sizeof(v)); }
+  size_t putUInt(const char *k, uint32_t v)        { return putBytes(k, &v, sizeof(v)); }
+  size_t putULong(const char *k, uint32_t v)       { return putBytes(k, &v, sizeof(v)); }
+  float    getFloat(const char *k, float d = 0)    { return get(k, d); }
+  int32_t  getInt(const char *k, int32_t d = 0)    { return get(k, d); }
+  uint32_t getUInt(const char *k, uint32_t d = 0)  { return get(k, d); }
+  uint32_t getULong(const char *k, uint32_t d = 0) { return get(k, d); }
+
+private:
+  std::string ns;
+  bool ro = false;
+
+  std::map<std::string, std::vector<uint8_t>> &table() { return host::nvs[ns]; }
+
+  template <typename T> T get(const char *key, T def) {
+    T v;
+    return getBytes(key, &v, sizeof(v)) == sizeof(v) ? v : def;
+  }
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+// ---------- Host I2C ----------
+// Each bus forwards transactions to one emulated device (the simulator
+// attaches them); an empty bus NACKs everything like a missing sensor.
+namespace host {
+  struct I2cDevice {
+    virtual bool   write(uint8_t addr, const uint8_t *data, size_t len) = 0;   // true = ACK
+    virtual size_t read(uint8_t addr, uint8_t *data, size_t len) = 0;
+    virtual ~I2cDevice() {}
+  };
+}
+
+class TwoWire {
+public:
+  host::I2cDevice *device = nullptr;
+
+  bool begin(int sda = -1, int scl = -1, uint32_t freq = 0) { (void)sda; (void)scl; (void)freq; return true; }
+  void setClock(uint32_t) {}
+
+  void beginTransmission(uint8_t a) { addr = a; txLen = 0; }
+  size_t write(uint8_t b) { if (txLen < sizeof(tx)) tx[txLen++] = b; return 1; }
+  size_t write(const uint8_t *d, size_t n) { for (size_t i = 0; i < n; i++) write(d[i]); return n; }
+  uint8_t endTransmission(bool = true) { return device && device->write(addr, tx, txLen) ? 0 : 2; }
+
+  uint8_t requestFrom(uint8_t a, uint8_t n) {
+    if (n > sizeof(rx)) n = sizeof(rx);
+    rxLen = device ? device->read(a, rx, n) : 0;
+    rxPos = 0;
+    return rxLen;
+  }
+  int available() { return rxLen - rxPos; }
+  int read() { return rxPos < rxLen ? rx[rxPos++] : -1; }
+
+private:
+  uint8_t addr = 0;
+  uint8_t tx[32], rx[32];
+  size_t  txLen = 0, rxLen = 0, rxPos = 0;
+};
+
+inline TwoWire Wire, Wire1;
+
+#endif